@@ -0,0 +1,67 @@
+#include "AccountRoster.hpp"
+
+namespace
+{
+AccountRoster::account from_record(const bts::wallet::wallet_account_record& record)
+{
+  AccountRoster::account a;
+  a.name = record.name;
+  a.owner_key = record.owner_key;
+  a.active_key = record.active_key();
+  a.is_delegate = record.is_delegate();
+  return a;
+}
+} // anonymous
+
+void AccountRoster::reset(const std::vector<bts::wallet::wallet_account_record>& records)
+{
+  std::map<std::string, account> accounts;
+  for (const auto& record : records)
+    accounts[record.name] = from_record(record);
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  _accounts.swap(accounts);
+}
+
+bool AccountRoster::update(const bts::wallet::wallet_account_record& record)
+{
+  account updated = from_record(record);
+  std::lock_guard<std::mutex> lock(_mutex);
+  account& current = _accounts[record.name];
+  bool changed = current.name.empty() || current.owner_key != updated.owner_key ||
+                 current.active_key != updated.active_key || current.is_delegate != updated.is_delegate;
+  current = updated;
+  return changed;
+}
+
+bool AccountRoster::remove(const std::string& name)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _accounts.erase(name) != 0;
+}
+
+void AccountRoster::clear()
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  _accounts.clear();
+}
+
+std::vector<AccountRoster::account> AccountRoster::accounts() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  std::vector<account> accounts;
+  accounts.reserve(_accounts.size());
+  for (const auto& entry : _accounts)
+    accounts.push_back(entry.second);
+  return accounts;
+}
+
+std::vector<std::string> AccountRoster::names() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  std::vector<std::string> names;
+  names.reserve(_accounts.size());
+  for (const auto& entry : _accounts)
+    names.push_back(entry.first);
+  return names;
+}
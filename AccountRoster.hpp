@@ -0,0 +1,41 @@
+#pragma once
+
+#include <bts/blockchain/types.hpp>
+#include <bts/wallet/wallet_records.hpp>
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/** What the GUI needs to know about the wallet's accounts, kept in memory so listing them
+    doesn't go through the wallet database. ClientWrapper loads it when a wallet is opened and
+    then updates single accounts as calls change them; safe to read from any thread meanwhile.
+*/
+class AccountRoster
+{
+public:
+  struct account
+  {
+    std::string                      name;
+    bts::blockchain::public_key_type owner_key;
+    bts::blockchain::public_key_type active_key;
+    bool                             is_delegate = false;
+  };
+
+  /// Replaces all accounts.
+  void reset(const std::vector<bts::wallet::wallet_account_record>& records);
+  /// Adds the account or replaces what is known about it; returns whether anything changed.
+  bool update(const bts::wallet::wallet_account_record& record);
+  /// Returns whether the account was there.
+  bool remove(const std::string& name);
+  void clear();
+
+  /// Sorted by name.
+  std::vector<account> accounts() const;
+  std::vector<std::string> names() const;
+
+private:
+  mutable std::mutex             _mutex;
+  std::map<std::string, account> _accounts;
+};
@@ -0,0 +1,52 @@
+#include "AddressFilter.hpp"
+
+#include <algorithm>
+
+namespace
+{
+//Two independent 64 bit hashes from the address' bytes, combined as h1 + i*h2 (Kirsch and Mitzenmacher)
+void address_hashes(const bts::blockchain::address& a, uint64_t& h1, uint64_t& h2)
+{
+  const uint32_t* words = a.addr._hash;
+  h1 = uint64_t(words[0]) << 32 | words[1];
+  //Odd, so successive probes visit distinct bits
+  h2 = (uint64_t(words[2]) << 32 | words[3]) | 1;
+}
+} // anonymous
+
+void AddressFilter::rebuild(const std::unordered_set<bts::blockchain::address>& addresses)
+{
+  //About 10 bits per address, rounded up to a power of two so probes are masked instead of divided
+  uint64_t bit_count = 64;
+  while (bit_count < addresses.size() * 10)
+    bit_count <<= 1;
+  _bits.assign(bit_count / 64, 0);
+  _mask = bit_count - 1;
+
+  for (const auto& a : addresses)
+  {
+    uint64_t h1, h2;
+    address_hashes(a, h1, h2);
+    for (int i = 0; i < hash_count; ++i)
+    {
+      uint64_t bit = (h1 + i * h2) & _mask;
+      _bits[bit / 64] |= uint64_t(1) << (bit % 64);
+    }
+  }
+}
+
+bool AddressFilter::may_contain(const bts::blockchain::address& a) const
+{
+  if (_bits.empty())
+    return false;
+
+  uint64_t h1, h2;
+  address_hashes(a, h1, h2);
+  for (int i = 0; i < hash_count; ++i)
+  {
+    uint64_t bit = (h1 + i * h2) & _mask;
+    if (!(_bits[bit / 64] & uint64_t(1) << (bit % 64)))
+      return false;
+  }
+  return true;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <bts/blockchain/address.hpp>
+
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+/** Bloom filter over a set of addresses, sized for about a 1% false positive rate. It answers
+    "certainly not in the set" from a few bits that fit in cache however large the wallet is,
+    so most outputs in a block are rejected before the exact lookup. Addresses are already
+    hashes, so the bit positions are taken straight from their bytes. The filter can't drop
+    addresses; rebuild it when the wallet's keys change.
+*/
+class AddressFilter
+{
+public:
+  AddressFilter() {}
+  explicit AddressFilter(const std::unordered_set<bts::blockchain::address>& addresses) { rebuild(addresses); }
+
+  void rebuild(const std::unordered_set<bts::blockchain::address>& addresses);
+  /// False if the address is certainly not in the set; true if it may be.
+  bool may_contain(const bts::blockchain::address& a) const;
+
+  size_t size_in_bytes() const { return _bits.size() * sizeof(uint64_t); }
+
+private:
+  static const int hash_count = 7;
+
+  std::vector<uint64_t> _bits;
+  uint64_t              _mask = 0;
+};
@@ -3,7 +3,10 @@
 #include "html5viewer/html5viewer.h"
 #include "ClientWrapper.hpp"
 #include "Utilities.hpp"
+#include "Metrics.hpp"
 #include "MainWindow.hpp"
+#include "SingleInstanceServer.hpp"
+#include "WebNetworkAccessManager.hpp"
 
 #include <boost/thread.hpp>
 #include <bts/blockchain/config.hpp>
@@ -20,8 +23,9 @@
 #include <QWebPage>
 #include <QWebFrame>
 #include <QJsonDocument>
-#include <QGraphicsWebView>
+#include <QJsonObject>
 #include <QTimer>
+#include <QKeyEvent>
 #include <QAuthenticator>
 #include <QNetworkReply>
 #include <QResource>
@@ -30,11 +34,11 @@
 #include <QMenuBar>
 #include <QLayout>
 #include <QLocalSocket>
-#include <QLocalServer>
 #include <QMessageBox>
 #include <QProxyStyle>
 #include <QComboBox>
 #include <QTemporaryFile>
+#include <QFile>
 #include <QTranslator>
 #include <QLibraryInfo>
 
@@ -61,9 +65,56 @@
 #include <boost/iostreams/stream.hpp>
 
 #include <fstream>
+#include <cstdlib>
 #include <iostream>
 #include <iomanip>
 
+namespace
+{
+/// Keeps the splash screen from hiding on click, and quits when it is closed or Escape is pressed.
+class SplashQuitFilter : public QObject
+{
+public:
+   virtual bool eventFilter(QObject* object, QEvent* event) override
+   {
+      switch (event->type())
+      {
+      case QEvent::MouseButtonPress:
+         return true;
+      case QEvent::KeyPress:
+         if (static_cast<QKeyEvent*>(event)->key() != Qt::Key_Escape)
+            return true;
+         //Fall through
+      case QEvent::Close:
+         wlog("Quit requested during startup");
+         QCoreApplication::quit();
+         return true;
+      default:
+         return QObject::eventFilter(object, event);
+      }
+   }
+};
+
+/// For --startup-report: once the wallet is usable, writes the startup milestones to the given file and quits.
+void writeStartupReportWhenInteractive(const QString& reportPath)
+{
+   QTimer* poll = new QTimer(qApp);
+   QObject::connect(poll, &QTimer::timeout, [poll, reportPath] {
+      QVariantMap milestones = Metrics::milestones();
+      if (!milestones.contains("interactive") || !milestones.contains("first_rpc_answered"))
+         return;
+      poll->stop();
+
+      QFile report(reportPath);
+      if (!report.open(QIODevice::WriteOnly) || report.write(QJsonDocument::fromVariant(milestones).toJson()) == -1)
+         elog("Unable to write startup report to ${path}", ("path", reportPath.toStdString()));
+      QCoreApplication::quit();
+   });
+   poll->start(10);
+}
+
+} /// anonymous
+
 // enable crashrpt win32 release only
 #if defined(WIN32) && defined(USE_CRASHRPT) && defined(NDEBUG)
 
@@ -339,10 +390,10 @@ int BitSharesApp::run()
 
    MainWindow mainWindow;
    Utilities::app_id = mainWindow.getAppId();
-   bool crashedPreviously = mainWindow.detectCrash();
    installEventFilter(&mainWindow);
 
    //We'll go ahead and leave Win/Lin URL handling available in OSX too
+   SingleInstanceServer* singleInstanceServer = nullptr;
    QLocalSocket* sock = new QLocalSocket();
    sock->connectToServer(BTS_BLOCKCHAIN_NAME);
    if (sock->waitForConnected(100))
@@ -352,7 +403,7 @@ int BitSharesApp::run()
       {
          //Need to open a custom URL. Pass it to pre-existing instance.
          std::cout << "Found instance already running. Sending message and exiting." << std::endl;
-         sock->write( arguments()[1].toStdString().c_str());
+         sock->write(SingleInstanceServer::request("open_url", QJsonObject{{"url", arguments()[1]}}));
          sock->waitForBytesWritten();
          sock->close();
       }
@@ -371,16 +422,41 @@ int BitSharesApp::run()
       }
 
       //Could not connect to already-running instance. Start a server so future instances connect to us
-      QLocalServer* singleInstanceServer = startSingleInstanceServer(&mainWindow);
-      connect(this, &QApplication::aboutToQuit, singleInstanceServer, &QLocalServer::deleteLater);
+      singleInstanceServer = startSingleInstanceServer(&mainWindow);
+      connect(this, &QApplication::aboutToQuit, singleInstanceServer, &SingleInstanceServer::deleteLater);
    }
    delete sock;
 
    auto viewer = new Html5Viewer;
+   QSettings viewerSettings("BitShares", BTS_BLOCKCHAIN_NAME);
+   viewer->setRenderingOptions(Html5Viewer::RenderingOptions::fromSettings(viewerSettings));
    std::unique_ptr<ClientWrapper> clientWrapper(new ClientWrapper);
-
-   if (crashedPreviously)
-      clientWrapper->handle_crash();
+   auto networkAccessManager = new WebNetworkAccessManager(clientWrapper->assets(), viewer);
+   QObject::connect(networkAccessManager, &WebNetworkAccessManager::walletRpcSucceeded,
+                    clientWrapper.get(), &ClientWrapper::rpc_request_succeeded);
+   QObject::connect(networkAccessManager, &WebNetworkAccessManager::rpcStarted,
+                    clientWrapper.get(), &ClientWrapper::interactive_call_started);
+   QObject::connect(networkAccessManager, &WebNetworkAccessManager::rpcFinished,
+                    clientWrapper.get(), &ClientWrapper::interactive_call_finished);
+   viewer->webView()->page()->setNetworkAccessManager(networkAccessManager);
+   singleInstanceServer->addClientCommands(clientWrapper.get());
+
+   if (clientWrapper->detect_crash())
+   {
+      auto response = QMessageBox::question(nullptr,
+                                            tr("Crash Detected"),
+                                            tr("It appears that %1 crashed last time it was running. "
+                                               "If this is happening frequently, it could be caused by a "
+                                               "corrupted database. Would you like "
+                                               "to reset the database (this will take several minutes) or "
+                                               "to continue normally? Resetting the database will "
+                                               "NOT lose any of your information or funds.").arg(applicationName()),
+                                            tr("Reset Database"),
+                                            tr("Continue Normally"),
+                                            QString(), 1);
+      if (response == 0)
+         clientWrapper->reset_chain_database();
+   }
 
    mainWindow.setCentralWidget(viewer);
    mainWindow.setClientWrapper(clientWrapper.get());
@@ -395,8 +471,15 @@ int BitSharesApp::run()
    QSplashScreen splash(pixmap);
    splash.showMessage(QApplication::tr("Loading configuration..."),
                       Qt::AlignCenter | Qt::AlignBottom, Qt::white);
-   splash.setEnabled(false);
+   //Quitting from the splash screen stops a long replay; ClientWrapper::shutdown cancels startup
+   SplashQuitFilter splashQuitFilter;
+   splash.installEventFilter(&splashQuitFilter);
    splash.show();
+   Metrics::mark_milestone("splash_shown");
+
+   int startupReportIndex = arguments().indexOf("--startup-report");
+   if (startupReportIndex != -1 && arguments().size() > startupReportIndex + 1)
+      writeStartupReportWhenInteractive(arguments()[startupReportIndex + 1]);
 
    prepareStartupSequence(clientWrapper.get(), viewer, &mainWindow, &splash);
 
@@ -413,7 +496,15 @@ int BitSharesApp::run()
 #else
       clientWrapper->initialize(nullptr);
 #endif
+      //Load the GUI while the client replays the chain; its RPC calls wait until the client is up
+      viewer->webView()->load(QUrl(ClientWrapper::ui_origin() + "/"));
       int exec_result = exec();
+      if (!clientWrapper->shutdown())
+      {
+         elog("Client did not shut down in time; exiting without waiting for it");
+         std::cout.flush();
+         std::_Exit(exec_result);
+      }
       clientWrapper.reset();
       /*
     * We restore the initial logging config here in order to destroy all of the current
@@ -448,11 +539,25 @@ void setupMenus(ClientWrapper* client, MainWindow* mainWindow)
    accountMenu->addAction(QApplication::tr("Create Account"), mainWindow, SLOT(goToCreateAccount()), QKeySequence(QApplication::tr("Ctrl+Shift+C")));
    accountMenu->addAction(QApplication::tr("Import Account"))->setEnabled(false);
    accountMenu->addAction(QApplication::tr("New Contact"), mainWindow, SLOT(goToAddContact()), QKeySequence(QApplication::tr("Ctrl+Shift+N")));
+
+   //Listed from the account roster, so rebuilding the menu doesn't touch the wallet
+   auto openAccountMenu = accountMenu->addMenu(QApplication::tr("Open Account"));
+   auto fillOpenAccountMenu = [client, mainWindow, openAccountMenu] {
+      openAccountMenu->clear();
+      for( const auto& name : client->account_roster().names() )
+      {
+         QString accountName = QString::fromStdString(name);
+         openAccountMenu->addAction(accountName, [mainWindow, accountName] { mainWindow->goToAccount(accountName); });
+      }
+      openAccountMenu->setEnabled(!openAccountMenu->isEmpty());
+   };
+   fillOpenAccountMenu();
+   QObject::connect(client, &ClientWrapper::account_roster_changed, openAccountMenu, fillOpenAccountMenu);
 }
 
 void BitSharesApp::prepareStartupSequence(ClientWrapper* client, Html5Viewer* viewer, MainWindow* mainWindow, QSplashScreen* splash)
 {
-   viewer->connect(viewer->webView(), &QGraphicsWebView::urlChanged, [viewer,client,mainWindow] (const QUrl& newUrl) {
+   viewer->connect(viewer->webView(), &Html5Viewer::WebView::urlChanged, [viewer,client,mainWindow] (const QUrl& newUrl) {
        ilog("loading for URL ${url}", ("url", newUrl.toString().toStdString()));
        mainWindow->updateLocationEdit(newUrl);
        
@@ -466,29 +571,51 @@ void BitSharesApp::prepareStartupSequence(ClientWrapper* client, Html5Viewer* vi
       viewer->webView()->page()->mainFrame()->addToJavaScriptWindowObject("application", mainWindow);
       viewer->webView()->page()->mainFrame()->addToJavaScriptWindowObject("bitshares", client);
       viewer->webView()->page()->mainFrame()->addToJavaScriptWindowObject("magic_unicorn", new Utilities, QWebFrame::ScriptOwnership);
+      viewer->webView()->page()->mainFrame()->addToJavaScriptWindowObject("metrics", new Metrics, QWebFrame::ScriptOwnership);
    });
    QObject::connect(viewer->webView()->page()->networkAccessManager(), &QNetworkAccessManager::authenticationRequired,
                     [client](QNetworkReply*, QAuthenticator* auth) {
-      auth->setUser(client->http_url().userName());
-      auth->setPassword(client->http_url().password());
+      auth->setUser(client->rpc_url().userName());
+      auth->setPassword(client->rpc_url().password());
    });
-   client->connect(client, &ClientWrapper::initialized, [viewer, client, mainWindow]() {
-      ilog("Client initialized; loading web interface from ${url}", ("url", client->http_url().toString().toStdString()));
+
+   //The GUI is preloaded during replay, so the client and the first page load may finish in either order.
+   //Once both are done, route the already running GUI to its start page and show it.
+   struct StartupState
+   {
+      bool initialized = false;
+      bool loaded = false;
+   };
+   auto state = std::make_shared<StartupState>();
+   auto finishStartup = [state, viewer, client, mainWindow, splash] {
+      if (!state->initialized || !state->loaded)
+         return;
+      ilog("Showing web interface at ${url}", ("url", client->http_url().toString().toStdString()));
+      viewer->webView()->page()->mainFrame()->evaluateJavaScript(
+               QStringLiteral("window.location.hash = '%1';").arg(client->http_url().fragment()));
+      //Not close(): closing the splash screen means quitting
+      splash->hide();
+      mainWindow->show();
+      Metrics::mark_milestone("interactive");
+      mainWindow->processDeferredUrl();
+   };
+
+   client->connect(client, &ClientWrapper::initialized, [state, finishStartup, viewer, client, mainWindow]() {
+      ilog("Client initialized; binding web interface to ${url}", ("url", client->rpc_url().toString(QUrl::RemoveUserInfo).toStdString()));
       client->status_update(tr("Finished connecting. Launching %1").arg(qApp->applicationName()));
-      viewer->webView()->load(client->http_url());
+      static_cast<WebNetworkAccessManager*>(viewer->webView()->page()->networkAccessManager())->setRpcEndpoint(client->rpc_url());
       //Now we know the URL of the app, so we can create the items in the Accounts menu
       setupMenus(client, mainWindow);
+      state->initialized = true;
+      finishStartup();
    });
    auto loadFinishedConnection = std::make_shared<QMetaObject::Connection>();
-   *loadFinishedConnection = viewer->connect(viewer->webView(), &QGraphicsWebView::loadFinished, [mainWindow, splash, viewer, loadFinishedConnection](bool ok) {
-      //Workaround for wallet_get_info RPC call failure in web_wallet
-      //viewer->webView()->reload();
-
+   *loadFinishedConnection = viewer->connect(viewer->webView(), &Html5Viewer::WebView::loadFinished, [state, finishStartup, viewer, loadFinishedConnection](bool ok) {
       ilog("Webview loaded: ${status}", ("status", ok));
+      Metrics::mark_milestone("web_view_loaded");
       viewer->disconnect(*loadFinishedConnection);
-      splash->close();
-      mainWindow->show();
-      mainWindow->processDeferredUrl();
+      state->loaded = true;
+      finishStartup();
    });
    client->connect(client, &ClientWrapper::error, [=](QString errorString) {
       splash->hide();
@@ -502,43 +629,26 @@ void BitSharesApp::prepareStartupSequence(ClientWrapper* client, Html5Viewer* vi
 
 }
 
-QLocalServer* BitSharesApp::startSingleInstanceServer(MainWindow* mainWindow)
+SingleInstanceServer* BitSharesApp::startSingleInstanceServer(MainWindow* mainWindow)
 {
-   QLocalServer* singleInstanceServer = new QLocalServer();
+   SingleInstanceServer* singleInstanceServer = new SingleInstanceServer();
    if (!singleInstanceServer->listen(BTS_BLOCKCHAIN_NAME))
    {
-      std::cerr << "Could not start new instance listener. Attempting to remove defunct listener... ";
-      QLocalServer::removeServer(BTS_BLOCKCHAIN_NAME);
-      if (!singleInstanceServer->listen(BTS_BLOCKCHAIN_NAME))
-      {
-         std::cerr << "Failed to start new instance listener: " << singleInstanceServer->errorString().toStdString() << std::endl;
-         exit(1);
-      }
-      std::cerr << "Success.\n";
+      std::cerr << "Failed to start new instance listener: " << singleInstanceServer->errorString().toStdString() << std::endl;
+      exit(1);
    }
 
    std::cout << "Listening for new instances on " << singleInstanceServer->fullServerName().toStdString() << std::endl;
-   singleInstanceServer->connect(singleInstanceServer, &QLocalServer::newConnection, [singleInstanceServer, mainWindow](){
-      QLocalSocket* zygote = singleInstanceServer->nextPendingConnection();
-      QEventLoop waitLoop;
-
-      zygote->connect(zygote, &QLocalSocket::readyRead, &waitLoop, &QEventLoop::quit);
-      QTimer::singleShot(1000, &waitLoop, SLOT(quit()));
-      waitLoop.exec();
-
+   connect(singleInstanceServer, &SingleInstanceServer::instanceStarted, mainWindow, &MainWindow::takeFocus);
+   singleInstanceServer->setCommandHandler("open_url", [mainWindow](const QJsonObject& request, SingleInstanceServer::Responder respond) {
       mainWindow->takeFocus();
-
-      if (zygote->bytesAvailable())
-      {
-         QByteArray message = zygote->readLine();
-         ilog("Got message from new instance: ${msg}", ("msg", message.data()));
-         mainWindow->processCustomUrl(message);
-      }
-      zygote->close();
-
-      delete zygote;
+      mainWindow->processCustomUrl(request.value("url").toString());
+      respond(true, QString());
+   });
+   singleInstanceServer->setCommandHandler("check_updates", [mainWindow](const QJsonObject&, SingleInstanceServer::Responder respond) {
+      mainWindow->checkWebUpdates(false);
+      respond(QStringLiteral("started"), QString());
    });
-
    return singleInstanceServer;
 }
 
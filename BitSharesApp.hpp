@@ -8,7 +8,7 @@ class ClientWrapper;
 class Html5Viewer;
 class MainWindow;
 class QSplashScreen;
-class QLocalServer;
+class SingleInstanceServer;
 
 /** Subclass needed to reimplement 'notify' method and catch unknown exceptions.
 */
@@ -28,7 +28,7 @@ class BitSharesApp : protected QApplication
     int run();
 
     void prepareStartupSequence(ClientWrapper* client, Html5Viewer* viewer, MainWindow* mainWindow, QSplashScreen* splash);
-    QLocalServer* startSingleInstanceServer(MainWindow* mainWindow);
+    SingleInstanceServer* startSingleInstanceServer(MainWindow* mainWindow);
 
     void onExceptionCaught(const fc::exception& e);
     void onUnknownExceptionCaught();
@@ -0,0 +1,212 @@
+#include "BitSharesDaemon.hpp"
+#include "ClientWrapper.hpp"
+
+#include <bts/blockchain/config.hpp>
+#include <bts/blockchain/time.hpp>
+#include <bts/utilities/git_revision.hpp>
+
+#include <fc/log/logger.hpp>
+#include <fc/log/logger_config.hpp>
+#include <fc/thread/thread.hpp>
+
+#include <QCoreApplication>
+#include <QNetworkReply>
+#include <QSettings>
+
+#include <signal.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+
+namespace
+{
+/// Set from the signal handler; polled from the event loop, where quitting is safe.
+volatile sig_atomic_t g_stopRequested = 0;
+
+void requestStop(int)
+{
+   g_stopRequested = 1;
+}
+
+QString argumentValue(const QStringList& arguments, const QString& name)
+{
+   int index = arguments.indexOf(name);
+   if (index != -1 && arguments.size() > index + 1)
+      return arguments[index + 1];
+   return QString();
+}
+} /// anonymous
+
+BitSharesDaemon::BitSharesDaemon(ClientWrapper* client)
+   : _client(client),
+     _version(parseClientVersion(bts::utilities::git_revision_description))
+{
+   QSettings settings("BitShares", BTS_BLOCKCHAIN_NAME);
+   if (settings.contains("app_id"))
+      _appId = QUuid(settings.value("app_id").toString());
+   else {
+      _appId = QUuid::createUuid();
+      settings.setValue("app_id", _appId.toString());
+   }
+
+   //Check every 20 minutes, restarting the timer only after the current check has finished
+   _updateChecker.setInterval(1200000);
+   _updateChecker.setSingleShot(true);
+   connect(&_updateChecker, &QTimer::timeout, [this] { checkWebUpdates(); });
+   _updateChecker.start();
+}
+
+bool BitSharesDaemon::startCommandServer()
+{
+   if (!_commandServer.listen(BTS_BLOCKCHAIN_NAME))
+   {
+      elog("Unable to listen for local commands: ${e}", ("e", _commandServer.errorString().toStdString()));
+      return false;
+   }
+
+   _commandServer.addClientCommands(_client);
+   _commandServer.setCommandHandler("check_updates", [this](const QJsonObject&, SingleInstanceServer::Responder respond) {
+      checkWebUpdates();
+      respond(QStringLiteral("started"), QString());
+   });
+   ilog("Listening for local commands on ${name}", ("name", _commandServer.fullServerName().toStdString()));
+   return true;
+}
+
+void BitSharesDaemon::loadWebUpdates()
+{
+   WebUpdateManifest::UpdateDetails description;
+   WebPackageFiles files;
+   if (!loadInstalledWebUpdate(QDir(_client->get_data_dir()), description, files))
+      return;
+
+   //Unlike the GUI, don't lock the wallet: RPC clients of a daemon don't go through the web GUI
+   _client->set_web_package(std::move(files));
+   _version.patchVersion = description.patchVersion;
+}
+
+void BitSharesDaemon::checkWebUpdates()
+{
+   QDir dataDir(_client->get_data_dir());
+   removeIncompleteWebUpdate(dataDir);
+
+   QNetworkReply* manifestReply = _network.get(QNetworkRequest(webUpdatesManifestUrl(_appId, bts::utilities::git_revision_description)));
+   connect(manifestReply, &QNetworkReply::finished, [this, manifestReply, dataDir] {
+      manifestReply->deleteLater();
+
+      WebUpdateManifest::UpdateDetails update;
+      try
+      {
+         QByteArray data = manifestReply->readAll();
+         auto manifest = fc::json::from_string(std::string(data.data(), data.size())).as<WebUpdateManifest>();
+         if (!findWebUpdate(manifest, _version, update))
+         {
+            _updateChecker.start();
+            return;
+         }
+      }
+      catch (fc::exception& e)
+      {
+         elog("Error during update checking: ${e}", ("e", e.to_detail_string()));
+         _updateChecker.start();
+         return;
+      }
+
+      QNetworkReply* packageReply = _network.get(QNetworkRequest(QUrl(update.updatePackageUrl.c_str())));
+      connect(packageReply, &QNetworkReply::finished, [this, packageReply, dataDir, update] {
+         packageReply->deleteLater();
+
+         QByteArray package = packageReply->readAll();
+         if (verifyWebUpdateSignature(update, package) && installWebUpdate(dataDir, update, package))
+         {
+            wlog("Installing web update ${major}.${fork}.${minor}-${patch}",
+                 ("major", update.majorVersion)("fork", update.forkVersion)("minor", update.minorVersion)("patch", std::string(1, update.patchVersion)));
+            loadWebUpdates();
+         }
+         _updateChecker.start();
+      });
+   });
+}
+
+int BitSharesDaemon::run(int& argc, char** argv)
+{
+   QCoreApplication app(argc, argv);
+   app.setOrganizationName("DACPLAY");
+   app.setOrganizationDomain("dacplay.org");
+   app.setApplicationName(BTS_BLOCKCHAIN_NAME);
+
+   signal(SIGINT, &requestStop);
+   signal(SIGTERM, &requestStop);
+
+   try
+   {
+      std::unique_ptr<ClientWrapper> clientWrapper(new ClientWrapper);
+      //Before touching the data directory, which a running instance owns
+      BitSharesDaemon daemon(clientWrapper.get());
+      if (!daemon.startCommandServer())
+         return 1;
+      if (clientWrapper->detect_crash())
+         wlog("${app} crashed last time it was running; if this keeps happening, the chain database may be corrupted "
+              "and can be reset by removing the chain directory", ("app", app.applicationName().toStdString()));
+
+      const QStringList arguments = app.arguments();
+      QString httpdEndpoint = argumentValue(arguments, "--httpd-endpoint");
+      QString rpcUser = argumentValue(arguments, "--rpc-user");
+      QString rpcPassword = argumentValue(arguments, "--rpc-password");
+      if (!httpdEndpoint.isEmpty() || !rpcUser.isEmpty() || !rpcPassword.isEmpty())
+         clientWrapper->set_rpc_access(fc::ip::endpoint::from_string(httpdEndpoint.isEmpty() ? "127.0.0.1:0" : httpdEndpoint.toStdString()),
+                                       rpcUser.toStdString(), rpcPassword.toStdString());
+
+      daemon.loadWebUpdates();
+
+      QObject::connect(clientWrapper.get(), &ClientWrapper::status_update, [](QString status) {
+         ilog("${status}", ("status", status.toStdString()));
+      });
+      QObject::connect(clientWrapper.get(), &ClientWrapper::error, [](QString error) {
+         elog("${error}", ("error", error.toStdString()));
+         QCoreApplication::exit(1);
+      });
+      QObject::connect(clientWrapper.get(), &ClientWrapper::initialized, [&clientWrapper] {
+         std::string endpoint = std::string(*clientWrapper->get_httpd_endpoint());
+         ilog("Client is running; JSON-RPC and /metrics.json are served on ${endpoint}", ("endpoint", endpoint));
+         std::cout << "Listening on " << endpoint << std::endl;
+      });
+
+      QTimer fc_tasks;
+      fc_tasks.connect(&fc_tasks, &QTimer::timeout, [] {
+         fc::usleep(fc::microseconds(1000));
+         if (g_stopRequested)
+            QCoreApplication::quit();
+      });
+      fc_tasks.start(33);
+
+      clientWrapper->initialize(nullptr);
+      int exec_result = app.exec();
+      ilog("Shutting down");
+      if (!clientWrapper->shutdown())
+      {
+         elog("Client did not shut down in time; exiting without waiting for it");
+         std::cout.flush();
+         std::_Exit(exec_result);
+      }
+      clientWrapper.reset();
+
+      //See BitSharesApp::run for why logging is reset before leaving
+      bts::blockchain::shutdown_ntp_time();
+      ilog("stop logging (shutting down)");
+      fc::configure_logging(fc::logging_config::default_config());
+      return exec_result;
+   }
+   catch (const fc::exception& e)
+   {
+      elog("Unhandled exception: ${e}", ("e", e.to_detail_string()));
+      std::cerr << e.to_detail_string() << std::endl;
+   }
+   catch (...)
+   {
+      elog("Unhandled unknown exception");
+      std::cerr << "Unhandled unknown exception" << std::endl;
+   }
+   return 1;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "SingleInstanceServer.hpp"
+#include "WebUpdates.hpp"
+
+#include <QNetworkAccessManager>
+#include <QObject>
+#include <QTimer>
+#include <QUuid>
+
+class ClientWrapper;
+
+/** Runs the client on a QCoreApplication, without any window or web view, for servers
+    which only need its JSON-RPC interface. Uses the same data dir, settings, web update
+    package and /metrics.json endpoint as the GUI. Built as its own executable (see
+    daemon_main.cpp), which links neither WebKit nor the widgets.
+*/
+class BitSharesDaemon : public QObject
+{
+  Q_OBJECT
+
+  public:
+    /** Builds the application object, runs the client until SIGINT or SIGTERM and shuts it down.
+        Besides --data-dir, understands --httpd-endpoint <ip:port>, --rpc-user and --rpc-password.
+    */
+    static int run(int& argc, char** argv);
+
+  private:
+    BitSharesDaemon(ClientWrapper* client);
+
+    /// Answers CommandClient on the same local socket a GUI instance would use.
+    /// Fails if another instance, GUI or daemon, is already running.
+    bool startCommandServer();
+
+    void loadWebUpdates();
+    /// Same checks as the GUI, except that a verified update is installed without asking.
+    void checkWebUpdates();
+
+  private:
+    ClientWrapper*        _client;
+    QNetworkAccessManager _network;
+    QTimer                _updateChecker;
+    ClientVersion         _version;
+    QUuid                 _appId;
+    SingleInstanceServer  _commandServer;
+};
@@ -0,0 +1,45 @@
+#include "BlockCache.hpp"
+
+fc::optional<bts::blockchain::digest_block> BlockCache::find(const bts::blockchain::block_id_type& block_id)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto found = _index.find(block_id);
+  if (found == _index.end())
+    return fc::optional<bts::blockchain::digest_block>();
+
+  _entries.splice(_entries.begin(), _entries, found->second);
+  return found->second->second;
+}
+
+void BlockCache::insert(const bts::blockchain::block_id_type& block_id, const bts::blockchain::digest_block& digest)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto found = _index.find(block_id);
+  if (found != _index.end())
+  {
+    found->second->second = digest;
+    _entries.splice(_entries.begin(), _entries, found->second);
+    return;
+  }
+
+  _entries.emplace_front(block_id, digest);
+  _index[block_id] = _entries.begin();
+  if (_entries.size() > _capacity)
+  {
+    _index.erase(_entries.back().first);
+    _entries.pop_back();
+  }
+}
+
+void BlockCache::clear()
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  _entries.clear();
+  _index.clear();
+}
+
+size_t BlockCache::size() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _entries.size();
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <bts/blockchain/block.hpp>
+#include <bts/blockchain/types.hpp>
+
+#include <fc/optional.hpp>
+
+#include <algorithm>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+/** Bounded least recently used map from block id to the block's digest, so looking up blocks
+    that were recently applied or asked for doesn't go to the chain database. Safe to use from
+    any thread: ClientWrapper fills it on the bitshares thread and reads it on the GUI thread.
+*/
+class BlockCache
+{
+public:
+  explicit BlockCache(size_t capacity) : _capacity(std::max<size_t>(1, capacity)) {}
+
+  /// Marks the block as most recently used if found.
+  fc::optional<bts::blockchain::digest_block> find(const bts::blockchain::block_id_type& block_id);
+  /// Evicts the least recently used block when full.
+  void insert(const bts::blockchain::block_id_type& block_id, const bts::blockchain::digest_block& digest);
+  void clear();
+
+  size_t size() const;
+
+private:
+  typedef std::pair<bts::blockchain::block_id_type, bts::blockchain::digest_block> entry;
+
+  size_t             _capacity;
+  mutable std::mutex _mutex;
+  //Most recently used first
+  std::list<entry>   _entries;
+  std::unordered_map<bts::blockchain::block_id_type, std::list<entry>::iterator> _index;
+};
@@ -0,0 +1,220 @@
+#include "BlockPipeline.hpp"
+
+#include <fc/crypto/base64.hpp>
+#include <fc/exception/exception.hpp>
+#include <fc/io/raw.hpp>
+#include <fc/log/logger.hpp>
+#include <fc/network/http/connection.hpp>
+#include <fc/network/resolve.hpp>
+#include <fc/thread/thread.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <set>
+
+namespace
+{
+/// GET of a path on a source given as http://[user:password@]host:port
+fc::http::reply http_get(const std::string& source, const std::string& path)
+{
+  std::string address = source;
+  if (address.compare(0, 7, "http://") == 0)
+    address.erase(0, 7);
+  address = address.substr(0, address.find('/'));
+  fc::http::headers headers;
+  auto at = address.rfind('@');
+  if (at != std::string::npos) {
+    //The embedded HTTP server wants the same credentials for files as for JSON-RPC
+    headers.push_back(fc::http::header("Authorization", "Basic " + fc::base64_encode(address.substr(0, at))));
+    address.erase(0, at + 1);
+  }
+  auto colon = address.rfind(':');
+  std::string host = colon == std::string::npos ? address : address.substr(0, colon);
+  uint16_t port = colon == std::string::npos ? 80 : uint16_t(std::stoul(address.substr(colon + 1)));
+  auto endpoints = fc::resolve(host, port);
+  FC_ASSERT(!endpoints.empty(), "Unable to resolve ${host}", ("host", host));
+
+  fc::http::connection connection;
+  connection.connect_to(endpoints.front());
+  fc::http::reply reply = connection.request("GET", path, std::string(), headers);
+  FC_ASSERT(reply.status == fc::http::reply::OK, "${source}${path} answered ${status}",
+            ("source", source)("path", path)("status", int(reply.status)));
+  return reply;
+}
+} // anonymous
+
+const uint32_t BlockPipeline::max_range_size;
+
+BlockPipeline::BlockPipeline(fetch_function fetch, config c)
+  : _fetch(fetch),
+    _config(c)
+{
+  //A larger range would come back short from every source and count against it as a failure
+  _config.range_size = std::min(std::max<uint32_t>(1, _config.range_size), max_range_size);
+  _config.max_buffered_ranges = std::max<uint32_t>(1, _config.max_buffered_ranges);
+  _config.max_source_failures = std::max<uint32_t>(1, _config.max_source_failures);
+}
+
+BlockPipeline::result BlockPipeline::run(uint32_t first_block, uint32_t last_block, const std::vector<std::string>& sources,
+                                         apply_function apply)
+{
+  typedef std::vector<bts::blockchain::full_block> block_range;
+  result outcome;
+  if (first_block > last_block)
+    return outcome;
+  FC_ASSERT(!sources.empty(), "No sources to sync from");
+
+  const fc::time_point started = fc::time_point::now();
+  const uint32_t range_count = uint32_t((uint64_t(last_block) - first_block + _config.range_size) / _config.range_size);
+
+  //Shared with the source threads, which are joined before this goes away
+  std::vector<fc::promise<block_range>::ptr> ranges;
+  for (uint32_t i = 0; i < range_count; ++i)
+    ranges.push_back(fc::promise<block_range>::ptr(new fc::promise<block_range>("block range")));
+  std::mutex             queue_mutex;
+  uint32_t               next_range = 0;
+  //Failed ranges, lowest first
+  std::set<uint32_t>     retry;
+  std::atomic<uint32_t>  applied_ranges{0};
+  std::atomic<uint32_t>  retried_ranges{0};
+  std::atomic<uint32_t>  sources_left{uint32_t(sources.size())};
+  std::atomic<bool>      stop{false};
+
+  auto take_range = [&](uint32_t& range) {
+    std::lock_guard<std::mutex> lock(queue_mutex);
+    if (!retry.empty()) {
+      range = *retry.begin();
+      retry.erase(retry.begin());
+      return true;
+    }
+    if (next_range < range_count) {
+      range = next_range++;
+      return true;
+    }
+    return false;
+  };
+
+  auto download = [&](const std::string& source) {
+    uint32_t failures = 0;
+    //Sources with nothing left to take stay around while ranges may still come back for a retry
+    while (!stop && applied_ranges < range_count)
+    {
+      uint32_t range;
+      if (!take_range(range)) {
+        fc::usleep(fc::milliseconds(10));
+        continue;
+      }
+      //Don't run further ahead of the applier than the reorder buffer allows. A failed range the
+      //applier may be waiting for comes first, or a dropped source could leave it stuck.
+      while (!stop && range >= applied_ranges + _config.max_buffered_ranges)
+      {
+        {
+          std::lock_guard<std::mutex> lock(queue_mutex);
+          if (!retry.empty() && *retry.begin() < range) {
+            retry.insert(range);
+            range = *retry.begin();
+            retry.erase(retry.begin());
+            continue;
+          }
+        }
+        fc::usleep(fc::milliseconds(5));
+      }
+      if (stop)
+        break;
+
+      uint32_t begin = first_block + range * _config.range_size;
+      uint32_t count = std::min<uint32_t>(_config.range_size, last_block - begin + 1);
+      try
+      {
+        block_range blocks = _fetch(source, begin, count);
+        FC_ASSERT(blocks.size() == count && blocks.front().block_num == begin,
+                  "Expected ${count} blocks from ${begin}", ("count", count)("begin", begin));
+        ranges[range]->set_value(std::move(blocks));
+        failures = 0;
+      }
+      catch (...)
+      {
+        if (stop)
+          break;
+        wlog("Fetching blocks ${begin} to ${end} from ${source} failed: ${e}",
+             ("begin", begin)("end", begin + count - 1)("source", source)("e", fc::except_str()));
+        {
+          std::lock_guard<std::mutex> lock(queue_mutex);
+          retry.insert(range);
+        }
+        ++retried_ranges;
+        if (++failures >= _config.max_source_failures) {
+          wlog("Not syncing from ${source} any more", ("source", source));
+          break;
+        }
+      }
+    }
+    --sources_left;
+  };
+
+  std::vector<std::unique_ptr<fc::thread>> threads;
+  std::vector<fc::future<void>> downloads;
+  auto finish = [&] {
+    stop = true;
+    for (auto& done : downloads)
+      try { done.wait(); } catch (const fc::exception&) {}
+    threads.clear();
+  };
+  for (size_t i = 0; i < sources.size(); ++i)
+  {
+    threads.emplace_back(new fc::thread("sync " + std::to_string(i)));
+    std::string source = sources[i];
+    downloads.push_back(threads.back()->async([&download, source] { download(source); }, "block download"));
+  }
+
+  try
+  {
+    for (uint32_t range = 0; range < range_count; ++range)
+    {
+      fc::time_point wait_started = fc::time_point::now();
+      fc::future<block_range> arrived(ranges[range]);
+      while (!arrived.ready())
+      {
+        FC_ASSERT(sources_left > 0, "No source left to fetch blocks ${begin} and on from",
+                  ("begin", first_block + range * _config.range_size));
+        try { arrived.wait(fc::milliseconds(100)); } catch (const fc::timeout_exception&) {}
+      }
+      block_range blocks = arrived.wait();
+      ranges[range].reset();
+      fc::time_point apply_started = fc::time_point::now();
+      outcome.waiting += apply_started - wait_started;
+
+      for (const auto& block : blocks)
+      {
+        apply(block);
+        ++outcome.blocks_applied;
+      }
+      outcome.applying += fc::time_point::now() - apply_started;
+      ++applied_ranges;
+    }
+  }
+  catch (...)
+  {
+    finish();
+    throw;
+  }
+  finish();
+
+  outcome.retried_ranges = retried_ranges;
+  outcome.elapsed = fc::time_point::now() - started;
+  return outcome;
+}
+
+std::vector<bts::blockchain::full_block> BlockPipeline::fetch_over_http(const std::string& source, uint32_t first_block, uint32_t count)
+{
+  fc::http::reply reply = http_get(source, "/blocks/" + std::to_string(first_block) + "/" + std::to_string(count));
+  return fc::raw::unpack<std::vector<bts::blockchain::full_block>>(reply.body);
+}
+
+uint32_t BlockPipeline::head_over_http(const std::string& source)
+{
+  fc::http::reply reply = http_get(source, "/blocks/head");
+  return uint32_t(std::stoul(std::string(reply.body.begin(), reply.body.end())));
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <bts/blockchain/block.hpp>
+
+#include <fc/time.hpp>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+/** Catch-up sync that overlaps downloading blocks with applying them. The blocks to fetch are
+    cut into ranges; each source gets a thread of its own that keeps taking the next range and
+    downloading it, while the calling thread applies the ranges strictly in order as they
+    arrive. Sources may run ahead of the applier by at most max_buffered_ranges ranges, which
+    bounds the memory held in the reorder buffer. A range that fails to download goes back to
+    be taken by any source; a source that fails max_source_failures times in a row is dropped.
+
+    Throughput approaches the slower of applying and the combined download rate of the sources.
+*/
+class BlockPipeline
+{
+public:
+  /// Blocks first_block to first_block + count - 1 from the source, in order; throws if the source can't provide them.
+  typedef std::function<std::vector<bts::blockchain::full_block>(const std::string& source, uint32_t first_block, uint32_t count)> fetch_function;
+  typedef std::function<void(const bts::blockchain::full_block& block)> apply_function;
+
+  /// Most blocks a source serves per request (see ClientWrapper); range_size is clamped to it.
+  static const uint32_t max_range_size = 1000;
+
+  struct config
+  {
+    uint32_t range_size = 100;
+    uint32_t max_buffered_ranges = 16;
+    uint32_t max_source_failures = 3;
+  };
+
+  struct result
+  {
+    uint32_t         blocks_applied = 0;
+    uint32_t         retried_ranges = 0;
+    fc::microseconds elapsed;
+    /// Time the applier spent applying blocks, and waiting for the next range to arrive.
+    fc::microseconds applying;
+    fc::microseconds waiting;
+  };
+
+  BlockPipeline(fetch_function fetch, config c);
+
+  /** Fetches blocks first_block to last_block from the sources and applies them in order on the
+      calling thread, which must be an fc::thread. Throws once no source is left, or if applying
+      a block throws; the blocks applied until then stay applied.
+  */
+  result run(uint32_t first_block, uint32_t last_block, const std::vector<std::string>& sources, apply_function apply);
+
+  /// @name Fetching from another wallet's embedded HTTP server, when it has sync/serve_blocks on (see ClientWrapper)
+  /// @{
+  /// GET <source>/blocks/<first>/<count>, answered with the fc::raw packed blocks.
+  static std::vector<bts::blockchain::full_block> fetch_over_http(const std::string& source, uint32_t first_block, uint32_t count);
+  /// GET <source>/blocks/head, answered with the head block number.
+  static uint32_t head_over_http(const std::string& source);
+  /// @}
+
+private:
+  fetch_function _fetch;
+  config         _config;
+};
@@ -0,0 +1,279 @@
+#include "ClientBackend.hpp"
+
+#include <bts/blockchain/chain_database.hpp>
+#include <bts/wallet/config.hpp>
+#include <bts/wallet/wallet.hpp>
+
+#include <algorithm>
+
+BtsClientBackend::BtsClientBackend(const std::string& user_agent)
+  : _client(std::make_shared<bts::client::client>(user_agent))
+{
+}
+
+void BtsClientBackend::open(const fc::path& data_dir, replay_progress_callback replay_progress)
+{
+  _client->open(data_dir, fc::optional<fc::path>(), fc::optional<bool>(), replay_progress);
+}
+
+bool BtsClientBackend::is_wallet_enabled()
+{
+  return _client->get_wallet()->is_enabled();
+}
+
+fc::optional<fc::ip::endpoint> BtsClientBackend::start_http_server(const bts::rpc::rpc_server::config& config,
+                                                                   http_file_callback file_callback)
+{
+  _client->get_rpc_server()->set_http_file_callback(file_callback);
+  _client->get_rpc_server()->configure_http(config);
+  return _client->get_rpc_server()->get_httpd_endpoint();
+}
+
+const bts::client::config& BtsClientBackend::configure(const fc::path& data_dir)
+{
+  return _client->configure(data_dir);
+}
+
+void BtsClientBackend::init_cli()
+{
+  _client->init_cli();
+}
+
+fc::ip::endpoint BtsClientBackend::listen()
+{
+  _client->listen_on_port(0, false /*don't wait if not available*/);
+  return _client->get_p2p_listening_endpoint();
+}
+
+fc::future<void> BtsClientBackend::start()
+{
+  _client->set_daemon_mode(true);
+  return _client->start();
+}
+
+void BtsClientBackend::start_networking(std::function<void()> connect_to_seeds)
+{
+  _client->start_networking(connect_to_seeds);
+}
+
+void BtsClientBackend::connect_to_peer(const std::string& peer)
+{
+  _client->connect_to_peer(peer);
+}
+
+std::vector<ClientBackend::peer_traffic> BtsClientBackend::network_get_peer_traffic()
+{
+  std::vector<peer_traffic> traffic;
+  for (const fc::variant_object& info : _client->network_get_peer_info(false))
+  {
+    peer_traffic peer;
+    if (info.contains("addr"))
+      peer.endpoint = info["addr"].as_string();
+    if (info.contains("bytessent"))
+      peer.bytes_sent = info["bytessent"].as_uint64();
+    if (info.contains("bytesrecv"))
+      peer.bytes_received = info["bytesrecv"].as_uint64();
+    traffic.push_back(peer);
+  }
+  return traffic;
+}
+
+void BtsClientBackend::stop()
+{
+  _client->stop();
+}
+
+void BtsClientBackend::close_chain()
+{
+  if (_block_observer)
+    _client->get_chain()->remove_observer(_block_observer.get());
+  _block_observer.reset();
+  _client->get_chain()->close();
+}
+
+fc::variant_object BtsClientBackend::get_info()
+{
+  return _client->get_info();
+}
+
+fc::variant BtsClientBackend::call(const std::string& method, const fc::variants& params)
+{
+  return _client->get_rpc_server()->direct_invoke_method(method, params);
+}
+
+std::vector<std::string> BtsClientBackend::wallet_list()
+{
+  return _client->wallet_list();
+}
+
+void BtsClientBackend::wallet_open(const std::string& wallet_name)
+{
+  _client->wallet_open(wallet_name);
+}
+
+void BtsClientBackend::wallet_close()
+{
+  _client->wallet_close();
+}
+
+bool BtsClientBackend::is_wallet_open()
+{
+  return _client->get_wallet()->is_open();
+}
+
+bool BtsClientBackend::is_wallet_unlocked()
+{
+  return _client->get_wallet()->is_unlocked();
+}
+
+void BtsClientBackend::wallet_unlock(const std::string& passphrase)
+{
+  _client->get_wallet()->unlock(passphrase, BTS_WALLET_DEFAULT_UNLOCK_TIME_SEC);
+}
+
+void BtsClientBackend::wallet_lock()
+{
+  if (auto wallet = _client->get_wallet())
+    wallet->lock();
+}
+
+fc::path BtsClientBackend::wallet_data_directory()
+{
+  return _client->get_wallet()->get_data_directory();
+}
+
+std::vector<bts::wallet::wallet_account_record> BtsClientBackend::wallet_list_accounts()
+{
+  return _client->wallet_list_accounts();
+}
+
+fc::optional<bts::wallet::wallet_account_record> BtsClientBackend::wallet_get_account(const std::string& account_name)
+{
+  try
+  {
+    return _client->wallet_get_account(account_name);
+  }
+  catch (const fc::exception&)
+  {
+    return fc::optional<bts::wallet::wallet_account_record>();
+  }
+}
+
+fc::ecc::compact_signature BtsClientBackend::wallet_sign_hash(const std::string& signer, const fc::sha256& hash)
+{
+  return _client->wallet_sign_hash(signer, hash);
+}
+
+void BtsClientBackend::wallet_approve(const std::string& account_name, bool approve)
+{
+  _client->wallet_approve(account_name, approve);
+}
+
+void BtsClientBackend::wallet_scan_transaction(const std::string& transaction_id)
+{
+  _client->wallet_scan_transaction(transaction_id);
+}
+
+void BtsClientBackend::wallet_backup_create(const fc::path& json_filename)
+{
+  _client->wallet_backup_create(json_filename);
+}
+
+void BtsClientBackend::wallet_backup_restore(const fc::path& json_filename, const std::string& wallet_name,
+                                             const std::string& passphrase)
+{
+  _client->wallet_backup_restore(json_filename, wallet_name, passphrase);
+}
+
+std::unordered_set<bts::blockchain::address> BtsClientBackend::wallet_addresses()
+{
+  std::unordered_set<bts::blockchain::address> addresses;
+  for (const auto& account : _client->wallet_list_accounts())
+  {
+    //The list also holds contacts, whose keys aren't the wallet's
+    if (!account.is_my_account)
+      continue;
+    for (const auto& key : _client->wallet_account_list_public_keys(account.name))
+      addresses.insert(bts::blockchain::address(bts::blockchain::public_key_type(key.native_pubkey)));
+  }
+  return addresses;
+}
+
+fc::optional<bts::blockchain::account_record> BtsClientBackend::blockchain_get_account(const std::string& account_name)
+{
+  return _client->blockchain_get_account(account_name);
+}
+
+fc::optional<bts::blockchain::account_record> BtsClientBackend::blockchain_get_account(const bts::blockchain::address& owner)
+{
+  return _client->get_chain()->get_account_record(owner);
+}
+
+bts::blockchain::digest_block BtsClientBackend::blockchain_get_block_digest(const bts::blockchain::block_id_type& block_id)
+{
+  return _client->get_chain()->get_block_digest(block_id);
+}
+
+namespace
+{
+class block_observer : public bts::blockchain::chain_observer
+{
+public:
+  explicit block_observer(ClientBackend::block_applied_callback callback) : _callback(std::move(callback)) {}
+
+  virtual void state_changed(const bts::blockchain::pending_chain_state_ptr&) override {}
+  virtual void block_applied(const bts::blockchain::block_summary& summary) override
+  {
+    _callback(summary.block.id(), bts::blockchain::digest_block(summary.block));
+  }
+
+private:
+  ClientBackend::block_applied_callback _callback;
+};
+} // anonymous
+
+void BtsClientBackend::subscribe_to_blocks(block_applied_callback callback)
+{
+  if (_block_observer)
+    _client->get_chain()->remove_observer(_block_observer.get());
+  _block_observer.reset(new block_observer(std::move(callback)));
+  _client->get_chain()->add_observer(_block_observer.get());
+}
+
+uint32_t BtsClientBackend::blockchain_head_block_num()
+{
+  return _client->get_chain()->get_head_block_num();
+}
+
+std::vector<bts::blockchain::signed_transaction> BtsClientBackend::blockchain_get_block_transactions(uint32_t block_num)
+{
+  return _client->get_chain()->get_block(block_num).user_transactions;
+}
+
+std::vector<fc::optional<bts::blockchain::address>>
+BtsClientBackend::blockchain_get_balance_owners(const std::vector<bts::blockchain::balance_id_type>& balance_ids)
+{
+  auto chain = _client->get_chain();
+  std::vector<fc::optional<bts::blockchain::address>> owners;
+  for (const auto& id : balance_ids)
+  {
+    auto record = chain->get_balance_record(id);
+    owners.push_back(record ? record->condition.owner() : fc::optional<bts::blockchain::address>());
+  }
+  return owners;
+}
+
+std::vector<bts::blockchain::full_block> BtsClientBackend::blockchain_get_blocks(uint32_t first_block, uint32_t count)
+{
+  auto chain = _client->get_chain();
+  uint32_t last = uint32_t(std::min<uint64_t>(uint64_t(first_block) + count, uint64_t(chain->get_head_block_num()) + 1));
+  std::vector<bts::blockchain::full_block> blocks;
+  for (uint32_t block_num = std::max<uint32_t>(1, first_block); block_num < last; ++block_num)
+    blocks.push_back(chain->get_block(block_num));
+  return blocks;
+}
+
+void BtsClientBackend::blockchain_push_block(const bts::blockchain::full_block& block)
+{
+  _client->get_chain()->push_block(block);
+}
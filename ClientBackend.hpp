@@ -0,0 +1,168 @@
+#pragma once
+
+#include <bts/blockchain/account_record.hpp>
+#include <bts/blockchain/address.hpp>
+#include <bts/blockchain/block.hpp>
+#include <bts/blockchain/chain_database.hpp>
+#include <bts/blockchain/transaction.hpp>
+#include <bts/blockchain/types.hpp>
+#include <bts/client/client.hpp>
+#include <bts/rpc/rpc_server.hpp>
+#include <bts/wallet/wallet_records.hpp>
+
+#include <fc/network/http/server.hpp>
+#include <fc/thread/future.hpp>
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+/** The parts of bts::client::client that ClientWrapper and MainWindow use. Everything goes
+    through this, so both can also run against FakeClientBackend, which needs no chain,
+    wallet files or peers. Threading rules are those of the real client: the startup calls
+    run on ClientWrapper's bitshares thread, the rest wherever they were called from before.
+*/
+class ClientBackend
+{
+public:
+  typedef std::function<void(float)> replay_progress_callback;
+  typedef std::function<void(const fc::path&, const fc::http::server::response&)> http_file_callback;
+  typedef std::function<void(const bts::blockchain::block_id_type&, const bts::blockchain::digest_block&)> block_applied_callback;
+
+  /// Bytes exchanged with a connected peer since the connection was made.
+  struct peer_traffic
+  {
+    std::string endpoint;
+    uint64_t    bytes_sent = 0;
+    uint64_t    bytes_received = 0;
+  };
+
+  virtual ~ClientBackend() {}
+
+  /// @name Startup, in the order ClientWrapper::initialize calls these
+  /// @{
+  /// Opens the chain, replaying it if needed; the callback gets the percentage done.
+  virtual void open(const fc::path& data_dir, replay_progress_callback replay_progress) = 0;
+  virtual bool is_wallet_enabled() = 0;
+  /// Serves JSON-RPC and, through the callback, files. Returns where it listens, if it could be started.
+  virtual fc::optional<fc::ip::endpoint> start_http_server(const bts::rpc::rpc_server::config& config,
+                                                           http_file_callback file_callback) = 0;
+  virtual const bts::client::config& configure(const fc::path& data_dir) = 0;
+  virtual void init_cli() = 0;
+  /// Starts listening for peers and returns the endpoint.
+  virtual fc::ip::endpoint listen() = 0;
+  /// Starts the client; the future completes once it has stopped.
+  virtual fc::future<void> start() = 0;
+  /// Starts the peer to peer network, then runs connect_to_seeds on the client's thread.
+  virtual void start_networking(std::function<void()> connect_to_seeds) = 0;
+  /// @}
+
+  virtual void connect_to_peer(const std::string& peer) = 0;
+  virtual std::vector<peer_traffic> network_get_peer_traffic() = 0;
+  virtual void stop() = 0;
+  virtual void close_chain() = 0;
+
+  virtual fc::variant_object get_info() = 0;
+  /// Invokes a JSON-RPC method the way the HTTP server would, without going through it.
+  virtual fc::variant call(const std::string& method, const fc::variants& params) = 0;
+
+  virtual std::vector<std::string> wallet_list() = 0;
+  virtual void wallet_open(const std::string& wallet_name) = 0;
+  virtual void wallet_close() = 0;
+  virtual bool is_wallet_open() = 0;
+  virtual bool is_wallet_unlocked() = 0;
+  virtual void wallet_unlock(const std::string& passphrase) = 0;
+  /// Does nothing while there is no wallet.
+  virtual void wallet_lock() = 0;
+  virtual fc::path wallet_data_directory() = 0;
+  virtual std::vector<bts::wallet::wallet_account_record> wallet_list_accounts() = 0;
+  /// Empty if the wallet has no such account.
+  virtual fc::optional<bts::wallet::wallet_account_record> wallet_get_account(const std::string& account_name) = 0;
+  virtual fc::ecc::compact_signature wallet_sign_hash(const std::string& signer, const fc::sha256& hash) = 0;
+  virtual void wallet_approve(const std::string& account_name, bool approve) = 0;
+  virtual void wallet_scan_transaction(const std::string& transaction_id) = 0;
+  virtual void wallet_backup_create(const fc::path& json_filename) = 0;
+  virtual void wallet_backup_restore(const fc::path& json_filename, const std::string& wallet_name,
+                                     const std::string& passphrase) = 0;
+  /// Addresses of every key of the open wallet's own accounts; contacts' keys are left out.
+  virtual std::unordered_set<bts::blockchain::address> wallet_addresses() = 0;
+
+  virtual fc::optional<bts::blockchain::account_record> blockchain_get_account(const std::string& account_name) = 0;
+  virtual fc::optional<bts::blockchain::account_record> blockchain_get_account(const bts::blockchain::address& owner) = 0;
+  /// Throws if the block is unknown.
+  virtual bts::blockchain::digest_block blockchain_get_block_digest(const bts::blockchain::block_id_type& block_id) = 0;
+  /// Calls back on the bitshares thread for every block applied from now on, until close_chain(). One subscriber only.
+  virtual void subscribe_to_blocks(block_applied_callback callback) = 0;
+  virtual uint32_t blockchain_head_block_num() = 0;
+  /// Like every chain read, only on the bitshares thread: the chain database isn't safe to share between threads.
+  virtual std::vector<bts::blockchain::signed_transaction> blockchain_get_block_transactions(uint32_t block_num) = 0;
+  /// The single owner of each balance, in order; empty for balances the chain doesn't know or with several owners.
+  virtual std::vector<fc::optional<bts::blockchain::address>>
+  blockchain_get_balance_owners(const std::vector<bts::blockchain::balance_id_type>& balance_ids) = 0;
+  /// Blocks first_block to first_block + count - 1, or fewer if the chain ends before. On the bitshares thread only, like blockchain_get_block_transactions.
+  virtual std::vector<bts::blockchain::full_block> blockchain_get_blocks(uint32_t first_block, uint32_t count) = 0;
+  /// Applies the next block of the chain; throws if it doesn't follow the head or is invalid.
+  virtual void blockchain_push_block(const bts::blockchain::full_block& block) = 0;
+};
+
+/// ClientBackend on top of the real bts::client::client.
+class BtsClientBackend : public ClientBackend
+{
+public:
+  explicit BtsClientBackend(const std::string& user_agent);
+
+  bts::client::client& client() { return *_client; }
+
+  virtual void open(const fc::path& data_dir, replay_progress_callback replay_progress) override;
+  virtual bool is_wallet_enabled() override;
+  virtual fc::optional<fc::ip::endpoint> start_http_server(const bts::rpc::rpc_server::config& config,
+                                                           http_file_callback file_callback) override;
+  virtual const bts::client::config& configure(const fc::path& data_dir) override;
+  virtual void init_cli() override;
+  virtual fc::ip::endpoint listen() override;
+  virtual fc::future<void> start() override;
+  virtual void start_networking(std::function<void()> connect_to_seeds) override;
+  virtual void connect_to_peer(const std::string& peer) override;
+  virtual std::vector<peer_traffic> network_get_peer_traffic() override;
+
+  virtual void stop() override;
+  virtual void close_chain() override;
+
+  virtual fc::variant_object get_info() override;
+  virtual fc::variant call(const std::string& method, const fc::variants& params) override;
+
+  virtual std::vector<std::string> wallet_list() override;
+  virtual void wallet_open(const std::string& wallet_name) override;
+  virtual void wallet_close() override;
+  virtual bool is_wallet_open() override;
+  virtual bool is_wallet_unlocked() override;
+  virtual void wallet_unlock(const std::string& passphrase) override;
+  virtual void wallet_lock() override;
+  virtual fc::path wallet_data_directory() override;
+  virtual std::vector<bts::wallet::wallet_account_record> wallet_list_accounts() override;
+  virtual fc::optional<bts::wallet::wallet_account_record> wallet_get_account(const std::string& account_name) override;
+  virtual fc::ecc::compact_signature wallet_sign_hash(const std::string& signer, const fc::sha256& hash) override;
+  virtual void wallet_approve(const std::string& account_name, bool approve) override;
+  virtual void wallet_scan_transaction(const std::string& transaction_id) override;
+  virtual void wallet_backup_create(const fc::path& json_filename) override;
+  virtual void wallet_backup_restore(const fc::path& json_filename, const std::string& wallet_name,
+                                     const std::string& passphrase) override;
+  virtual std::unordered_set<bts::blockchain::address> wallet_addresses() override;
+
+  virtual fc::optional<bts::blockchain::account_record> blockchain_get_account(const std::string& account_name) override;
+  virtual fc::optional<bts::blockchain::account_record> blockchain_get_account(const bts::blockchain::address& owner) override;
+  virtual bts::blockchain::digest_block blockchain_get_block_digest(const bts::blockchain::block_id_type& block_id) override;
+  virtual void subscribe_to_blocks(block_applied_callback callback) override;
+  virtual uint32_t blockchain_head_block_num() override;
+  virtual std::vector<bts::blockchain::signed_transaction> blockchain_get_block_transactions(uint32_t block_num) override;
+  virtual std::vector<fc::optional<bts::blockchain::address>>
+  blockchain_get_balance_owners(const std::vector<bts::blockchain::balance_id_type>& balance_ids) override;
+  virtual std::vector<bts::blockchain::full_block> blockchain_get_blocks(uint32_t first_block, uint32_t count) override;
+  virtual void blockchain_push_block(const bts::blockchain::full_block& block) override;
+
+private:
+  std::shared_ptr<bts::client::client> _client;
+  std::unique_ptr<bts::blockchain::chain_observer> _block_observer;
+};
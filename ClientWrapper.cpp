@@ -1,25 +1,36 @@
 #include "ClientWrapper.hpp"
+#ifdef QT_WALLET_MOCK_CLIENT
+#include "FakeClientBackend.hpp"
+#endif
+#include "Metrics.hpp"
+#include "PeerDialer.hpp"
+#include "WalletRescanner.hpp"
 
 #include <bts/blockchain/time.hpp>
 #include <bts/net/upnp.hpp>
 #include <bts/net/config.hpp>
 #include <bts/db/exception.hpp>
 
-#include <QApplication>
-#include <QResource>
+#include <fc/io/raw.hpp>
+
+#include <QCoreApplication>
 #include <QSettings>
+#include <QJsonArray>
 #include <QJsonDocument>
 #include <QUrl>
-#include <QMessageBox>
 #include <QDir>
 
-#include <iostream>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <set>
+#include <thread>
 
 #define WALLET_NAME "default"
 
 void ClientWrapper::get_htdocs_file( const fc::path& filename, const fc::http::server::response& r )
 {
-  std::cout << filename.generic_string() << "\n";
+  dlog("Serving ${name}", ("name", filename));
 
   auto give_404 = [&] {
     elog("404 on file ${name}", ("name", filename));
@@ -35,74 +46,192 @@ void ClientWrapper::get_htdocs_file( const fc::path& filename, const fc::http::s
     r.write(data, size);
   };
 
-  //Check the update package first, then fall back to QRC.
-  if (!_web_package.empty()) {
-    auto file = _web_package.find(filename.to_native_ansi_path());
-    if (file == _web_package.end())
+  if (filename.generic_string() == "metrics.json") {
+    QByteArray metrics = Metrics::snapshot_json().toUtf8();
+    return give_200(metrics.data(), metrics.size());
+  }
+
+  //Blocks for other wallets catching up (see catch_up); off unless sync/serve_blocks is set
+  const std::string name = filename.generic_string();
+  if (_serve_blocks && _client && name.compare(0, 7, "blocks/") == 0) {
+    try
+    {
+      std::vector<char> body;
+      if (name == "blocks/head") {
+        std::string head = std::to_string(_client->blockchain_head_block_num());
+        body.assign(head.begin(), head.end());
+      } else {
+        auto slash = name.find('/', 7);
+        FC_ASSERT(slash != std::string::npos);
+        uint32_t first_block = uint32_t(std::stoul(name.substr(7, slash - 7)));
+        uint32_t count = std::min<uint32_t>(uint32_t(std::stoul(name.substr(slash + 1))), BlockPipeline::max_range_size);
+        body = fc::raw::pack(_client->blockchain_get_blocks(first_block, count));
+      }
+      r.set_status(fc::http::reply::OK);
+      r.set_length(body.size());
+      r.write(body.data(), body.size());
+      return;
+    }
+    catch (...)
+    {
+      //Malformed range, or no chain to read
       return give_404();
-    return give_200(file->second.data(), file->second.size());
+    }
   }
 
-  //No update package. Use QRC.
-  QResource  file_to_send(("/htdocs/htdocs/" + filename.generic_string()).c_str());
-  if(!file_to_send.data())
+  auto asset = _assets.find(filename);
+  if (!asset.found())
     return give_404();
-
-  r.set_status(fc::http::reply::OK);
-  if(file_to_send.isCompressed())
-  {
-    auto data = qUncompress(file_to_send.data(), file_to_send.size());
-    return give_200(data.data(), data.size());
-  }
-  return give_200((const char*)file_to_send.data(), file_to_send.size());
+  return give_200(asset.data(), asset.size());
 }
 
 ClientWrapper::ClientWrapper(QObject *parent)
   : QObject(parent),
     _bitshares_thread("bitshares"),
-    _settings("BitShares", BTS_BLOCKCHAIN_NAME)
+    _settings("BitShares", BTS_BLOCKCHAIN_NAME),
+    _block_cache(_settings.value("chain/block_cache_size", 10000).toUInt())
 {
 }
 
 ClientWrapper::~ClientWrapper()
 {
-  _init_complete.wait();
-  QSettings("BitShares", BTS_BLOCKCHAIN_NAME).setValue("crash_state", "no_crash");
-  if (_client)
-     _bitshares_thread.async([this]{
-       _client->stop();
-       /*
-       _client->wallet_close();
-       _client->get_chain()->close();
-       _client->get_rpc_server()->shutdown_rpc_server();
-       _client->get_rpc_server()->wait_till_rpc_server_shutdown();
-       */
-       _client_done.wait(); //wait for client to shut down
-       _client.reset();
-     }).wait();
-}
-
-void ClientWrapper::handle_crash()
-{
-  auto response = QMessageBox::question(nullptr,
-                                        tr("Crash Detected"),
-                                        tr("It appears that %1 crashed last time it was running. "
-                                           "If this is happening frequently, it could be caused by a "
-                                           "corrupted database. Would you like "
-                                           "to reset the database (this will take several minutes) or "
-                                           "to continue normally? Resetting the database will "
-                                           "NOT lose any of your information or funds.").arg(qApp->applicationName()),
-                                        tr("Reset Database"),
-                                        tr("Continue Normally"),
-                                        QString(), 1);
-  if (response == 0)
-    QDir((get_data_dir() + "/chain")).removeRecursively();
+  shutdown();
+}
+
+bool ClientWrapper::shutdown()
+{
+  if (_shutdown_attempted)
+    return _shutdown_completed;
+  _shutdown_attempted = true;
+
+  int timeout_ms = _settings.value("client/shutdown_timeout_ms", 10000).toInt();
+  fc::time_point started = fc::time_point::now();
+  fc::time_point deadline = started + fc::milliseconds(timeout_ms);
+  bool completed = true;
+
+  auto timed = [](const char* step, std::function<void()> work) {
+    return [step, work] {
+      fc::time_point step_started = fc::time_point::now();
+      work();
+      Metrics::record(std::string("shutdown.") + step + "_ms", (fc::time_point::now() - step_started).count() / 1000.0);
+    };
+  };
+  auto wait_for = [&](const char* step, fc::future<void>& done) {
+    try
+    {
+      done.wait_until(deadline);
+    }
+    catch (const fc::timeout_exception&)
+    {
+      elog("Shutdown step ${step} did not finish within ${ms} ms", ("step", step)("ms", timeout_ms));
+      Metrics::increment("shutdown.timeouts");
+      completed = false;
+    }
+    catch (const fc::exception& e)
+    {
+      elog("Shutdown step ${step} failed: ${e}", ("step", step)("e", e.to_detail_string()));
+    }
+  };
+
+  //Startup notices this between replayed blocks and init phases
+  cancel_startup();
+  if (_init_complete.valid())
+    wait_for("startup", _init_complete);
+
+  //Unmapping the port only talks to the router, so it runs alongside everything else
+  std::unique_ptr<fc::thread> upnp_thread(new fc::thread("upnp teardown"));
+  fc::future<void> upnp_done = upnp_thread->async(timed("upnp", [this] { _upnp_service.reset(); }));
+
+  if (completed && _client)
+  {
+    fc::future<void> stop_done = _bitshares_thread.async(timed("client_stop", [this] {
+      if (_sync_sampling.valid() && !_sync_sampling.ready())
+        _sync_sampling.cancel_and_wait();
+      if (_catch_up.valid() && !_catch_up.ready())
+        _catch_up.cancel_and_wait();
+      _client->stop();
+      if (_client_done.valid())
+        _client_done.wait();
+    }));
+    wait_for("client_stop", stop_done);
+
+    if (completed)
+    {
+      //The client no longer applies blocks, so this is a consistent point to persist the wallet
+      //and then the chain from. Both belong to the bitshares thread, and the wallet uses the
+      //chain while it closes, so they are closed there one after the other.
+      fc::future<void> wallet_done = _bitshares_thread.async(timed("wallet_close", [this] { _client->wallet_close(); }));
+      wait_for("wallet_close", wallet_done);
+      if (completed)
+      {
+        fc::future<void> chain_done = _bitshares_thread.async(timed("chain_close", [this] { _client->close_chain(); }));
+        wait_for("chain_close", chain_done);
+      }
+    }
+
+    if (completed)
+    {
+      fc::future<void> release_done = _bitshares_thread.async(timed("client_release", [this] { _client.reset(); }));
+      wait_for("client_release", release_done);
+    }
+  }
+  wait_for("upnp", upnp_done);
+
+  Metrics::record("shutdown.total_ms", (fc::time_point::now() - started).count() / 1000.0);
+  if (completed)
+    _settings.setValue("crash_state", "no_crash");
+  else
+  {
+    //Distinct from "crashed": the data is most likely fine, and the chain database checks itself on open
+    _settings.setValue("crash_state", "shutdown_timeout");
+    //Joining threads that are still busy would block; the caller is about to exit the process anyway
+    upnp_thread.release();
+  }
+  _shutdown_completed = completed;
+  return completed;
+}
+
+void ClientWrapper::set_client_factory(std::function<std::shared_ptr<ClientBackend>()> factory)
+{
+  _client_factory = factory;
+}
+
+void ClientWrapper::cancel_startup()
+{
+  _startup_cancelled = true;
+}
+
+void ClientWrapper::check_startup_cancelled()
+{
+  if (_startup_cancelled)
+    FC_THROW_EXCEPTION(fc::canceled_exception, "Client startup cancelled");
+}
+
+bool ClientWrapper::detect_crash()
+{
+  QString crash_state = _settings.value("crash_state", "no_crash").toString();
+
+  //Set to crashed for the duration of execution; the destructor sets it back before exiting
+  _settings.setValue("crash_state", "crashed");
+
+  return crash_state == "crashed";
+}
+
+void ClientWrapper::reset_chain_database()
+{
+  wlog("Resetting the chain database");
+  QDir((get_data_dir() + "/chain")).removeRecursively();
+}
+
+void ClientWrapper::set_rpc_access(const fc::ip::endpoint& httpd_endpoint, const std::string& user, const std::string& password)
+{
+  _rpc_access = rpc_access{httpd_endpoint, user, password};
 }
 
 void ClientWrapper::set_web_package(std::unordered_map<std::string, std::vector<char>>&& web_package)
 {
   wlog("Using update package to serve web GUI");
-  _web_package = std::move(web_package);
+  _assets.set_package(std::move(web_package));
 }
 
 QString ClientWrapper::get_data_dir()
@@ -124,41 +253,102 @@ void ClientWrapper::initialize(INotifier* notifier)
   std::string default_wallet_name = _settings.value("client/default_wallet_name", WALLET_NAME).toString().toStdString();
   _settings.setValue("client/default_wallet_name", QString::fromStdString(default_wallet_name));
 
+  if( _rpc_access )
+  {
+    _cfg.rpc.rpc_user       = _rpc_access->user;
+    _cfg.rpc.rpc_password   = _rpc_access->password;
+    _cfg.rpc.httpd_endpoint = _rpc_access->httpd_endpoint;
+  }
+  else
+  {
 #ifdef _WIN32
-  _cfg.rpc.rpc_user = "";
-  _cfg.rpc.rpc_password = "";
+    _cfg.rpc.rpc_user = "";
+    _cfg.rpc.rpc_password = "";
 #else
-  _cfg.rpc.rpc_user     = "randomuser";
-  _cfg.rpc.rpc_password = fc::variant(fc::ecc::private_key::generate()).as_string();
+    _cfg.rpc.rpc_user     = "randomuser";
+    _cfg.rpc.rpc_password = fc::variant(fc::ecc::private_key::generate()).as_string();
 #endif
-  _cfg.rpc.httpd_endpoint = fc::ip::endpoint::from_string( "127.0.0.1:9999" );
-  _cfg.rpc.httpd_endpoint.set_port(0);
+    _cfg.rpc.httpd_endpoint = fc::ip::endpoint::from_string( "127.0.0.1:9999" );
+    _cfg.rpc.httpd_endpoint.set_port(0);
+  }
   ilog( "config: ${d}", ("d", fc::json::to_pretty_string(_cfg) ) );
 
+#ifdef QT_WALLET_MOCK_CLIENT
+  int mock_client_index = qApp->arguments().indexOf("--mock-client");
+  if (!_client_factory && mock_client_index != -1 && qApp->arguments().size() > mock_client_index+1)
+  {
+    auto script = FakeClientBackend::load_script(fc::path(qApp->arguments()[mock_client_index+1].toStdWString()));
+    wlog("Using a fake client instead of the real one");
+    _client_factory = [script] { return std::make_shared<FakeClientBackend>(script); };
+  }
+#endif
+
   auto data_dir = get_data_dir();
   wlog("Starting client with data-dir: ${ddir}", ("ddir", fc::path(data_dir.toStdWString())));
 
+  PeerDialer::config dialing;
+  dialing.parallel = _settings.value("network/p2p/parallel_dials", dialing.parallel).toUInt();
+  dialing.wanted = _settings.value("network/p2p/seed_connections", dialing.wanted).toUInt();
+  dialing.timeout = fc::milliseconds(_settings.value("network/p2p/dial_timeout_ms", 5000).toInt());
+
+  fc::microseconds sync_sample_interval = fc::milliseconds(_settings.value("sync/sample_interval_ms", 1000).toInt());
+
+  std::vector<std::string> block_sources;
+  for (const QString& source : _settings.value("sync/block_sources").toStringList())
+    block_sources.push_back(source.toStdString());
+  BlockPipeline::config pipelining;
+  pipelining.range_size = _settings.value("sync/range_size", pipelining.range_size).toUInt();
+  pipelining.max_buffered_ranges = _settings.value("sync/max_buffered_ranges", pipelining.max_buffered_ranges).toUInt();
+  _serve_blocks = _settings.value("sync/serve_blocks", false).toBool();
+
+  SyncThrottle::config budget;
+  budget.max_cpu_share = _settings.value("sync/max_cpu_share", budget.max_cpu_share).toDouble();
+  budget.max_bytes_per_s = _settings.value("sync/max_bytes_per_s", qulonglong(budget.max_bytes_per_s)).toULongLong();
+  budget.interactive_grace = fc::milliseconds(_settings.value("sync/interactive_grace_ms", 200).toInt());
+  _sync_throttle.set_config(budget);
+
   fc::thread* main_thread = &fc::thread::current();
+  QVariant interrupted_replay = _settings.value("replay/interrupted_at");
 
   _init_complete = _bitshares_thread.async( [=](){
     try
     {
       main_thread->async( [&]{ Q_EMIT status_update(tr("Starting %1").arg(qApp->applicationName())); });
-      _client = std::make_shared<bts::client::client>("qt_wallet");
-      _client->open( data_dir.toStdWString(), fc::optional<fc::path>(), fc::optional<bool>(), [=](float progress) {
-         main_thread->async( [=]{ Q_EMIT status_update(tr("Replaying blockchain... Approximately %1% complete.").arg(progress, 0, 'f', 0)); } );
+      _client = _client_factory ? _client_factory() : std::make_shared<BtsClientBackend>("qt_wallet");
+      check_startup_cancelled();
+      _client->open( data_dir.toStdWString(), [=](float progress) {
+         //Called between blocks of the replay; throwing here is the only way to stop it early
+         check_startup_cancelled();
+         _replay_progress = progress;
+         main_thread->async( [=]{
+           if (interrupted_replay.isValid())
+             Q_EMIT status_update(tr("Replaying blockchain... Approximately %1% complete (an earlier replay was stopped at %2%).")
+                                  .arg(progress, 0, 'f', 0).arg(interrupted_replay.toFloat(), 0, 'f', 0));
+           else
+             Q_EMIT status_update(tr("Replaying blockchain... Approximately %1% complete.").arg(progress, 0, 'f', 0));
+         } );
       } );
+      Metrics::mark_milestone("client_open");
+      _client->subscribe_to_blocks([this](const bts::blockchain::block_id_type& block_id, const bts::blockchain::digest_block& digest) {
+        _block_cache.insert(block_id, digest);
+        refresh_unconfirmed_accounts();
+        //Called from within push_block, so only counted here; catch-up paces between its blocks
+        _sync_throttle.block_applied();
+      });
+      if (_replay_progress >= 0)
+        QSettings("BitShares", BTS_BLOCKCHAIN_NAME).remove("replay");
+      check_startup_cancelled();
 
-      if(!_client->get_wallet()->is_enabled())
+      if(!_client->is_wallet_enabled())
           main_thread->async([&]{ Q_EMIT error(tr("Wallet is disabled in your configuration file. Please enable the wallet and relaunch the application.")); });
 
       // setup  RPC / HTTP services
       main_thread->async( [&]{ Q_EMIT status_update(tr("Loading...")); });
-      _client->get_rpc_server()->set_http_file_callback([this](const fc::path& filename, const fc::http::server::response& r) {
+      _actual_httpd_endpoint = _client->start_http_server( _cfg.rpc, [this](const fc::path& filename, const fc::http::server::response& r) {
           get_htdocs_file(filename, r);
       });
-      _client->get_rpc_server()->configure_http( _cfg.rpc );
-      _actual_httpd_endpoint = _client->get_rpc_server()->get_httpd_endpoint();
+      if( _actual_httpd_endpoint )
+        Metrics::mark_milestone("httpd_ready");
 
       // load config for p2p node.. creates cli
       const bts::client::config& loadedCfg = _client->configure( data_dir.toStdWString() );
@@ -167,22 +357,39 @@ void ClientWrapper::initialize(INotifier* notifier)
         notifier->on_config_loaded(loadedCfg);
 
       _client->init_cli();
+      check_startup_cancelled();
 
       main_thread->async( [&]{ Q_EMIT status_update(tr("Connecting to %1 network").arg(qApp->applicationName())); });
-      _client->listen_on_port(0, false /*don't wait if not available*/);
-      fc::ip::endpoint actual_p2p_endpoint = _client->get_p2p_listening_endpoint();
+      fc::ip::endpoint actual_p2p_endpoint = _client->listen();
 
-      _client->set_daemon_mode(true);
+      check_startup_cancelled();
       _client_done = _client->start();
       if( !_actual_httpd_endpoint )
       {
         main_thread->async( [&]{ Q_EMIT error( tr("Unable to start HTTP server...")); });
       }
 
-      _client->start_networking([=]{
-        for (std::string default_peer : _cfg.default_peers)
-          _client->connect_to_peer(default_peer);
+      //Seeds are dialed several at a time, best first by how they did in earlier sessions
+      auto default_peers = _cfg.default_peers;
+      fc::path peer_history = fc::path(data_dir.toStdWString()) / "peer_history.json";
+      _client->start_networking( [this, default_peers, peer_history, dialing](){
+        PeerDialer dialer(peer_history, dialing);
+        auto dialed = dialer.dial(default_peers, [this](const std::string& peer) {
+          try
+          {
+            _client->connect_to_peer(peer);
+          }
+          catch (const fc::exception& e)
+          {
+            wlog("Unable to connect to seed peer ${peer}: ${e}", ("peer", peer)("e", e.to_string()));
+          }
+        });
+        Metrics::record("network.seed_dial_ms", dialed.elapsed.count() / 1000.0);
+        Metrics::increment("network.seed_dial_failures", dialed.failed);
+        Metrics::set_gauge("network.seed_peers", dialed.connected.size());
       });
+      if( !block_sources.empty() )
+        _catch_up = fc::async( [this, block_sources, pipelining](){ catch_up(block_sources, pipelining); }, "catch up" );
 
       if( upnp )
       {
@@ -196,11 +403,35 @@ void ClientWrapper::initialize(INotifier* notifier)
       }
       catch(...)
       {}
+      load_account_roster();
+
+      _sync_monitor.reset(new SyncMonitor(_client));
+      _sync_sampling = fc::schedule( [this, sync_sample_interval](){ sample_sync(sync_sample_interval); },
+                                     fc::time_point::now() + sync_sample_interval, "sync sampling" );
 
-      main_thread->async( [&]{ Q_EMIT initialized(); });
+      main_thread->async( [&]{
+        _initialized = true;
+        Metrics::mark_milestone("initialized");
+        Q_EMIT initialized();
+      });
     }
     catch (...)
     {
+      //The replay may wrap our fc::canceled_exception, so go by the token rather than the exception type
+      if (_startup_cancelled)
+      {
+        //The chain directory is fine, just not fully replayed; keep it
+        wlog("Startup cancelled");
+        Metrics::increment("startup.cancelled");
+        if (_replay_progress >= 0)
+        {
+          wlog("Replay stopped at ${p}%", ("p", _replay_progress));
+          QSettings("BitShares", BTS_BLOCKCHAIN_NAME).setValue("replay/interrupted_at", _replay_progress);
+        }
+        _client.reset();
+        return;
+      }
+
       elog("Failure when attempting to initialize client; removing chain directory");
       if (fc::exists(fc::path(data_dir.toStdWString()) / "chain")) {
         fc::remove_all(fc::path(data_dir.toStdWString()) / "chain");
@@ -211,11 +442,14 @@ void ClientWrapper::initialize(INotifier* notifier)
   });
 }
 
+QString ClientWrapper::ui_origin()
+{
+  return QStringLiteral("http://localhost");
+}
+
 QUrl ClientWrapper::http_url() const
 {
-  QUrl url = QString::fromStdString("http://" + std::string( *_actual_httpd_endpoint ) + "/#/unlockwallet" );
-  url.setUserName(_cfg.rpc.rpc_user.c_str() );
-  url.setPassword(_cfg.rpc.rpc_password.c_str() );
+  QUrl url = ui_origin() + "/#/unlockwallet";
 
   std::vector<std::string> wallet_names;
   if( _client )
@@ -229,13 +463,453 @@ QUrl ClientWrapper::http_url() const
   return url;
 }
 
+QUrl ClientWrapper::rpc_url() const
+{
+  QUrl url = QString::fromStdString("http://" + std::string( *_actual_httpd_endpoint ) + "/rpc" );
+  url.setUserName(_cfg.rpc.rpc_user.c_str() );
+  url.setPassword(_cfg.rpc.rpc_password.c_str() );
+  return url;
+}
+
 QVariant ClientWrapper::get_info(  )
 {
+  //The web GUI is loaded while the client is still starting up
+  if( !_initialized )
+    return QVariant();
+
+  SyncThrottle::interactive_scope interactive(_sync_throttle);
   fc::variant_object result = _bitshares_thread.async( [this](){ return _client->get_info(); }).wait();
   std::string sresult = fc::json::to_string( result );
   return QJsonDocument::fromJson( QByteArray( sresult.c_str(), sresult.length() ) ).toVariant();
 }
 
+namespace
+{
+fc::variant to_fc_variant(const QVariant& value)
+{
+  //QJsonDocument only takes objects and arrays at the top level
+  QByteArray json = QJsonDocument::fromVariant(QVariantList() << value).toJson(QJsonDocument::Compact);
+  return fc::json::from_string(std::string(json.constData(), json.size())).get_array().front();
+}
+
+QVariant to_qvariant(const fc::variant& value)
+{
+  std::string json = fc::json::to_string(fc::variants{value});
+  return QJsonDocument::fromJson(QByteArray(json.c_str(), json.length())).array().first().toVariant();
+}
+} // anonymous
+
+fc::variant_object ClientWrapper::invoke(const std::string& method, const fc::variants& params)
+{
+  try
+  {
+    fc::variant result = _client->call(method, params);
+    update_account_roster(method, params);
+    return fc::mutable_variant_object("result", result);
+  }
+  catch (const fc::exception& e)
+  {
+    return fc::mutable_variant_object("error", e.to_string());
+  }
+}
+
+QVariant ClientWrapper::call(QString method, QVariantList params)
+{
+  if( !_initialized )
+    return QVariant();
+
+  std::string method_name = method.toStdString();
+  fc::variants fc_params = to_fc_variant(params).get_array();
+  SyncThrottle::interactive_scope interactive(_sync_throttle);
+  fc::variant_object response = _bitshares_thread.async( [&](){ return invoke(method_name, fc_params); }).wait();
+  return to_qvariant(response);
+}
+
+QVariantList ClientWrapper::call_batch(QVariantList calls)
+{
+  QVariantList responses;
+  if( !_initialized )
+    return responses;
+
+  std::vector<std::pair<std::string, fc::variants>> batch;
+  for( const QVariant& call : calls )
+  {
+    QVariantMap call_map = call.toMap();
+    batch.emplace_back(call_map.value("method").toString().toStdString(),
+                       to_fc_variant(call_map.value("params").toList()).get_array());
+  }
+
+  SyncThrottle::interactive_scope interactive(_sync_throttle);
+  fc::variants fc_responses = _bitshares_thread.async( [&](){
+    fc::variants results;
+    for( const auto& call : batch )
+      results.push_back(invoke(call.first, call.second));
+    return results;
+  }).wait();
+
+  for( const auto& response : fc_responses )
+    responses.push_back(to_qvariant(response));
+  return responses;
+}
+
+void ClientWrapper::rescan_wallet(uint32_t start_block_num, std::function<void(float)> progress,
+                                  const std::atomic<bool>* cancelled)
+{
+  fc::time_point started = fc::time_point::now();
+  std::unordered_set<bts::blockchain::address> addresses;
+  std::unordered_set<bts::blockchain::account_id_type> account_ids;
+  uint32_t head_block_num = 0;
+  _bitshares_thread.async( [&](){
+    addresses = _client->wallet_addresses();
+    //Only the wallet's own accounts, not its contacts; those not registered yet have no id to be paid by
+    for( const auto& account : _client->wallet_list_accounts() )
+      if( account.is_my_account && account.id != 0 )
+        account_ids.insert(account.id);
+    head_block_num = _client->blockchain_head_block_num();
+  }).wait();
+
+  //A settings object of our own, as this runs off the GUI thread
+  QSettings settings("BitShares", BTS_BLOCKCHAIN_NAME);
+  uint32_t thread_count = settings.value("wallet/rescan_threads", std::max(1u, std::thread::hardware_concurrency())).toUInt();
+  //Block 0 is the genesis state, not a block
+  uint32_t first_block_num = std::max(1u, start_block_num);
+  WalletRescanner scanner(_client, _bitshares_thread, std::move(addresses), std::move(account_ids), thread_count);
+  auto transaction_ids = scanner.scan(first_block_num, head_block_num, progress, cancelled);
+
+  _bitshares_thread.async( [&](){
+    for( const auto& id : transaction_ids )
+      _client->wallet_scan_transaction(std::string(id));
+  }).wait();
+
+  Metrics::record("rescan.ms", (fc::time_point::now() - started).count() / 1000.0);
+  Metrics::record("rescan.blocks", head_block_num >= first_block_num ? head_block_num - first_block_num + 1 : 0);
+  Metrics::increment("rescan.matches", transaction_ids.size());
+}
+
+void ClientWrapper::find_block(QString block_id)
+{
+  bts::blockchain::block_id_type id;
+  try
+  {
+    id = bts::blockchain::block_id_type(block_id.toStdString());
+  }
+  catch (const fc::exception&)
+  {
+    Q_EMIT block_found(block_id, -1);
+    return;
+  }
+
+  if( auto digest = _block_cache.find(id) )
+  {
+    Metrics::increment("block_cache.hits");
+    Q_EMIT block_found(block_id, digest->block_num);
+    return;
+  }
+  Metrics::increment("block_cache.misses");
+  if( !_initialized )
+  {
+    Q_EMIT block_found(block_id, -1);
+    return;
+  }
+
+  //Emitted from the bitshares thread, so it reaches receivers on the GUI thread queued
+  _bitshares_thread.async( [this, id, block_id](){
+    qint64 block_num = -1;
+    try
+    {
+      auto digest = _client->blockchain_get_block_digest(id);
+      _block_cache.insert(id, digest);
+      block_num = digest.block_num;
+    }
+    catch (const fc::exception&)
+    {
+    }
+    Q_EMIT block_found(block_id, block_num);
+  });
+}
+
+namespace
+{
+//Blocks to keep reading a newly registered account for, about ten minutes
+const uint32_t REGISTRATION_WATCH_BLOCKS = 60;
+} // anonymous
+
+void ClientWrapper::load_account_roster()
+{
+  try
+  {
+    if( _client->is_wallet_open() )
+      _account_roster.reset(_client->wallet_list_accounts());
+    else
+      _account_roster.clear();
+  }
+  catch (const fc::exception& e)
+  {
+    wlog("Unable to load the wallet's accounts: ${e}", ("e", e.to_detail_string()));
+    _account_roster.clear();
+  }
+  _unconfirmed_accounts.clear();
+  Q_EMIT account_roster_changed();
+}
+
+void ClientWrapper::reload_account_roster()
+{
+  _bitshares_thread.async( [this](){ load_account_roster(); });
+}
+
+void ClientWrapper::update_account_roster(const std::string& method, const fc::variants& params)
+{
+  //Calls that open, replace or close the whole wallet
+  static const std::set<std::string> wallet_changes = {
+    "wallet_open", "wallet_create", "wallet_close", "wallet_backup_restore", "wallet_import_keys_from_json"
+  };
+  //Calls that change one account, with the position of its name among the params
+  static const std::map<std::string, size_t> account_changes = {
+    {"wallet_account_create", 0}, {"wallet_account_register", 0}, {"wallet_account_update_registration", 0},
+    {"wallet_account_update_active_key", 0}, {"wallet_account_rename", 1}, {"wallet_add_contact_account", 0},
+    {"wallet_import_private_key", 1}
+  };
+
+  if( wallet_changes.count(method) )
+    return load_account_roster();
+
+  bool changed = false;
+  if( (method == "wallet_account_rename" || method == "wallet_remove_contact_account") && !params.empty() && params[0].is_string() )
+    changed = _account_roster.remove(params[0].as_string());
+
+  auto change = account_changes.find(method);
+  if( change != account_changes.end() && params.size() > change->second && params[change->second].is_string() )
+  {
+    std::string name = params[change->second].as_string();
+    auto record = _client->wallet_get_account(name);
+    changed = (record ? _account_roster.update(*record) : _account_roster.remove(name)) || changed;
+    if( method == "wallet_account_register" || method == "wallet_account_update_registration" )
+      _unconfirmed_accounts[name] = REGISTRATION_WATCH_BLOCKS;
+  }
+  if( changed )
+    Q_EMIT account_roster_changed();
+}
+
+void ClientWrapper::refresh_unconfirmed_accounts()
+{
+  bool changed = false;
+  for( auto account = _unconfirmed_accounts.begin(); account != _unconfirmed_accounts.end(); )
+  {
+    auto record = _client->wallet_get_account(account->first);
+    if( record )
+      changed = _account_roster.update(*record) || changed;
+    if( --account->second == 0 )
+      account = _unconfirmed_accounts.erase(account);
+    else
+      ++account;
+  }
+  if( changed )
+    Q_EMIT account_roster_changed();
+}
+
+QVariantList ClientWrapper::get_account_roster()
+{
+  QVariantList roster;
+  for( const auto& account : _account_roster.accounts() )
+  {
+    QVariantMap entry;
+    entry["name"] = QString::fromStdString(account.name);
+    entry["owner_key"] = QString::fromStdString(fc::variant(account.owner_key).as_string());
+    entry["active_key"] = QString::fromStdString(fc::variant(account.active_key).as_string());
+    entry["is_delegate"] = account.is_delegate;
+    roster.push_back(entry);
+  }
+  return roster;
+}
+
+void ClientWrapper::rpc_request_succeeded(QByteArray request)
+{
+  if( !_initialized )
+    return;
+
+  std::string body(request.constData(), request.size());
+  _bitshares_thread.async( [this, body](){
+    try
+    {
+      fc::variant parsed = fc::json::from_string(body);
+      fc::variants calls = parsed.is_array() ? parsed.get_array() : fc::variants{parsed};
+      for( const auto& call : calls )
+      {
+        const fc::variant_object& object = call.get_object();
+        if( object.contains("method") && object.contains("params") )
+          update_account_roster(object["method"].as_string(), object["params"].get_array());
+      }
+    }
+    catch (const fc::exception& e)
+    {
+      wlog("Unable to read a JSON-RPC request: ${e}", ("e", e.to_string()));
+    }
+  });
+}
+
+void ClientWrapper::sample_sync(fc::microseconds interval)
+{
+  try
+  {
+    SyncMonitor::sample sample = _sync_monitor->take_sample();
+
+    QVariantList peers;
+    for( const auto& peer : sample.peers )
+    {
+      QVariantMap entry;
+      entry["endpoint"] = QString::fromStdString(peer.endpoint);
+      entry["bytes_in_per_s"] = peer.bytes_in_per_s;
+      entry["bytes_out_per_s"] = peer.bytes_out_per_s;
+      peers.push_back(entry);
+    }
+    QVariantMap stats;
+    stats["head_block_num"] = sample.head_block_num;
+    stats["head_block_age_s"] = qulonglong(sample.head_block_age_s);
+    stats["blocks_per_s"] = sample.blocks_per_s;
+    stats["bytes_in_per_s"] = sample.bytes_in_per_s;
+    stats["bytes_out_per_s"] = sample.bytes_out_per_s;
+    stats["thread_busy"] = sample.thread_busy;
+    stats["bottleneck"] = QString::fromStdString(sample.bottleneck);
+    stats["peers"] = peers;
+
+    SyncThrottle::status throttled = _sync_throttle.take_status();
+    SyncThrottle::config budget = _sync_throttle.get_config();
+    QVariantMap throttle;
+    throttle["state"] = QString::fromStdString(throttled.state);
+    //Only catch-up is paced; the client's own sync applies its blocks where nothing can hold it back
+    throttle["catching_up"] = _catch_up.valid() && !_catch_up.ready();
+    throttle["max_cpu_share"] = budget.max_cpu_share;
+    throttle["max_bytes_per_s"] = qulonglong(budget.max_bytes_per_s);
+    throttle["yielding_share"] = throttled.yielding_share;
+    throttle["cpu_paused_share"] = throttled.cpu_paused_share;
+    throttle["bandwidth_paused_share"] = throttled.bandwidth_paused_share;
+    throttle["catch_up_bytes_per_s"] = throttled.bytes_per_s;
+    stats["throttle"] = throttle;
+
+    Metrics::set_gauge("sync.blocks_per_s", sample.blocks_per_s);
+    Metrics::set_gauge("sync.bytes_in_per_s", sample.bytes_in_per_s);
+    Metrics::set_gauge("sync.bytes_out_per_s", sample.bytes_out_per_s);
+    Metrics::set_gauge("sync.thread_busy", sample.thread_busy);
+    Metrics::set_gauge("sync.head_block_age_s", sample.head_block_age_s);
+    Metrics::set_gauge("sync.peers", sample.peers.size());
+    Metrics::set_gauge("sync.throttle_yielding_share", throttled.yielding_share);
+    Metrics::set_gauge("sync.throttle_cpu_paused_share", throttled.cpu_paused_share);
+    Metrics::set_gauge("sync.throttle_bandwidth_paused_share", throttled.bandwidth_paused_share);
+
+    {
+      std::lock_guard<std::mutex> lock(_sync_stats_mutex);
+      _sync_stats = stats;
+    }
+    Q_EMIT sync_stats_updated(stats);
+  }
+  catch (const fc::exception& e)
+  {
+    wlog("Unable to sample sync progress: ${e}", ("e", e.to_string()));
+  }
+
+  _sync_sampling = fc::schedule( [this, interval](){ sample_sync(interval); },
+                                 fc::time_point::now() + interval, "sync sampling" );
+}
+
+void ClientWrapper::push_block_paced(const bts::blockchain::full_block& block)
+{
+  _client->blockchain_push_block(block);
+  //Only while behind; a wallet in sync applies a block now and then and has nothing to hold back
+  if( fc::time_point::now() - fc::time_point(block.timestamp) > fc::seconds(SyncMonitor::synced_age_s) )
+    _sync_throttle.pace();
+}
+
+void ClientWrapper::catch_up(const std::vector<std::string>& sources, BlockPipeline::config pipelining)
+{
+  uint32_t target = 0;
+  for( const auto& source : sources )
+  {
+    try
+    {
+      target = std::max(target, BlockPipeline::head_over_http(source));
+    }
+    catch (const fc::exception& e)
+    {
+      wlog("Unable to get the head block from ${source}: ${e}", ("source", source)("e", e.to_string()));
+    }
+  }
+  uint32_t head = _client->blockchain_head_block_num();
+  if( target <= head )
+    return;
+
+  ilog("Catching up from block ${head} to ${target} from ${count} sources", ("head", head)("target", target)("count", sources.size()));
+  auto fetch = [this](const std::string& source, uint32_t first_block, uint32_t count) {
+    _sync_throttle.wait_for_bandwidth();
+    auto blocks = BlockPipeline::fetch_over_http(source, first_block, count);
+    _sync_throttle.downloaded(fc::raw::pack_size(blocks));
+    return blocks;
+  };
+  BlockPipeline pipeline(fetch, pipelining);
+  try
+  {
+    auto result = pipeline.run(head + 1, target, sources, [this](const bts::blockchain::full_block& block) {
+      //The client's own sync may have got there first, also while this block was being pushed
+      if( block.block_num <= _client->blockchain_head_block_num() )
+        return;
+      try
+      {
+        push_block_paced(block);
+      }
+      catch (const fc::canceled_exception&)
+      {
+        throw;
+      }
+      catch (const fc::exception&)
+      {
+        //Already known is as good as applied; only a block the chain still lacks is a failure
+        if( block.block_num > _client->blockchain_head_block_num() )
+          throw;
+      }
+    });
+    Metrics::record("sync.catch_up_ms", result.elapsed.count() / 1000.0);
+    Metrics::record("sync.catch_up_waiting_ms", result.waiting.count() / 1000.0);
+    Metrics::increment("sync.catch_up_blocks", result.blocks_applied);
+    Metrics::increment("sync.catch_up_retried_ranges", result.retried_ranges);
+    ilog("Caught up ${blocks} blocks in ${ms} ms", ("blocks", result.blocks_applied)("ms", result.elapsed.count() / 1000));
+  }
+  catch (const fc::canceled_exception&)
+  {
+    throw;
+  }
+  catch (const fc::exception& e)
+  {
+    //Whatever was applied stays; the client's own sync carries on from there
+    wlog("Catching up stopped: ${e}", ("e", e.to_string()));
+    Metrics::increment("sync.catch_up_failures");
+  }
+}
+
+QVariantMap ClientWrapper::get_sync_stats()
+{
+  std::lock_guard<std::mutex> lock(_sync_stats_mutex);
+  return _sync_stats;
+}
+
+void ClientWrapper::set_sync_budget(double max_cpu_share, qulonglong max_bytes_per_s)
+{
+  SyncThrottle::config budget = _sync_throttle.get_config();
+  budget.max_cpu_share = max_cpu_share;
+  budget.max_bytes_per_s = max_bytes_per_s;
+  _sync_throttle.set_config(budget);
+  _settings.setValue("sync/max_cpu_share", _sync_throttle.get_config().max_cpu_share);
+  _settings.setValue("sync/max_bytes_per_s", max_bytes_per_s);
+}
+
+void ClientWrapper::interactive_call_started()
+{
+  _sync_throttle.interactive_started();
+}
+
+void ClientWrapper::interactive_call_finished()
+{
+  _sync_throttle.interactive_finished();
+}
+
 QString ClientWrapper::get_http_auth_token()
 {
   QByteArray result = _cfg.rpc.rpc_user.c_str();
@@ -251,19 +925,6 @@ void ClientWrapper::set_data_dir(QString data_dir)
 
 void ClientWrapper::confirm_and_set_approval(QString delegate_name, bool approve)
 {
-  auto account = get_client()->blockchain_get_account(delegate_name.toStdString());
-  if( account.valid() && account->is_delegate() )
-  {
-    if( QMessageBox::question(nullptr,
-                              tr("Set Delegate Approval"),
-                              tr("Would you like to update approval rating of Delegate %1 to %2?")
-                              .arg(delegate_name)
-                              .arg(approve?"Approve":"Disapprove")
-                              )
-        == QMessageBox::Yes )
-      get_client()->wallet_approve(delegate_name.toStdString(), approve);
-  }
-  else
-    QMessageBox::warning(nullptr, tr("Invalid Account"), tr("Account %1 is not a delegate, so its approval cannot be set.").arg(delegate_name));
-
+  //Asking the user is up to the GUI; without one, nobody is connected and nothing changes
+  Q_EMIT approval_confirmation_requested(delegate_name, approve);
 }
@@ -1,13 +1,28 @@
 #pragma once
 
+#include "AccountRoster.hpp"
+#include "BlockCache.hpp"
+#include "BlockPipeline.hpp"
+#include "ClientBackend.hpp"
+#include "SyncMonitor.hpp"
+#include "SyncThrottle.hpp"
+#include "WebAssetStore.hpp"
+
 #include <QObject>
 #include <QSettings>
+#include <QUrl>
 #include <QVariant>
 
 #include <bts/rpc/rpc_server.hpp>
 #include <bts/client/client.hpp>
 #include <bts/net/upnp.hpp>
 
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+
 class ClientWrapper : public QObject 
 {
     Q_OBJECT
@@ -28,44 +43,187 @@ class ClientWrapper : public QObject
 
     ///Not done in constructor to allow caller to connect to error()
     void initialize(INotifier* notifier);
-
+    /** Stops the client, then closes the wallet and then the chain database, all on the
+        bitshares thread; only the UPnP mapping is torn down alongside. Gives up after
+        client/shutdown_timeout_ms (10 s by default) and returns false, in which case the
+        client is left running and the caller should exit the process without destroying
+        this object. Timings of each step are recorded as shutdown.* metrics.
+    */
+    bool shutdown();
+    /** Makes a running initialize() stop at the next replayed block or init phase; shutdown()
+        does this first. The chain is left as is. The bts library can't resume a replay midway,
+        so the next start replays from the beginning, but reports where the last one stopped
+        (kept in the replay/interrupted_at setting).
+    */
+    void cancel_startup();
+
+    /// The web GUI is served from memory under this origin, independent of where the
+    /// HTTP server ends up listening; see WebNetworkAccessManager.
+    static QString ui_origin();
+    /// Start page of the web GUI; only meaningful once initialized.
     QUrl http_url() const;
+    /// JSON-RPC endpoint of the embedded HTTP server, with credentials.
+    QUrl rpc_url() const;
+    bool is_initialized() const { return _initialized; }
+
     void set_web_package(std::unordered_map<std::string, std::vector<char>>&& web_package);
     bool has_web_package() {
-      return !_web_package.empty();
+      return _assets.has_package();
     }
+    const WebAssetStore& assets() const { return _assets; }
     
     fc::optional<fc::ip::endpoint>  get_httpd_endpoint() {return _actual_httpd_endpoint;}
 
     QString get_data_dir();
 
     Q_INVOKABLE QVariant get_info();
+    /** Invokes a JSON-RPC method on the bitshares thread, bypassing the HTTP server. Returns
+        {result: ...} or {error: message}, like the JSON-RPC response would; null until initialized.
+    */
+    Q_INVOKABLE QVariant call(QString method, QVariantList params);
+    /// Runs several [{method, params}] calls in one trip to the bitshares thread; one response per call, in order.
+    Q_INVOKABLE QVariantList call_batch(QVariantList calls);
     Q_INVOKABLE QString get_http_auth_token();
-    std::shared_ptr<bts::client::client> get_client() { return _client; }
-
-    void handle_crash();
+    /** Looks up the number of a block by id without blocking the caller. Blocks applied or looked
+        up recently are answered right away from a cache (chain/block_cache_size entries, 10000 by
+        default); others are read from the chain on the bitshares thread. Answers with block_found.
+    */
+    Q_INVOKABLE void find_block(QString block_id);
+
+    /** The open wallet's accounts, from memory. Loaded when the wallet is opened; after that
+        only the accounts named by calls that change accounts are read again, through the
+        bridge or JSON-RPC from the web GUI. Accounts just registered are read again as the
+        next blocks come in, until the registration has had time to confirm.
+    */
+    const AccountRoster& account_roster() const { return _account_roster; }
+    /// The account roster for the web GUI: [{name, owner_key, active_key, is_delegate}], sorted by name.
+    Q_INVOKABLE QVariantList get_account_roster();
+    /// Loads the roster afresh on the bitshares thread, for when the wallet was replaced underneath.
+    void reload_account_roster();
+
+    /** Latest sample of sync progress (see SyncMonitor), taken every sync/sample_interval_ms
+        (1000 by default) once initialized and also published as sync.* metrics:
+        {head_block_num, head_block_age_s, blocks_per_s, bytes_in_per_s, bytes_out_per_s,
+        thread_busy, bottleneck, peers: [{endpoint, bytes_in_per_s, bytes_out_per_s}],
+        throttle: {state, catching_up, max_cpu_share, max_bytes_per_s, yielding_share, cpu_paused_share,
+        bandwidth_paused_share, catch_up_bytes_per_s}}; see SyncThrottle::status for throttle.
+        The budgets only hold back catch-up from block sources, so they matter while catching_up.
+        Empty before the first sample.
+    */
+    Q_INVOKABLE QVariantMap get_sync_stats();
+    /** Sets the sync budgets (see SyncThrottle) and keeps them in the sync/max_cpu_share and
+        sync/max_bytes_per_s settings: the share of the bitshares thread's time above which
+        catch-up pauses, 1 for no limit, and the download rate for catching up, 0 for no limit.
+        The client's own peer to peer sync isn't held to them.
+    */
+    Q_INVOKABLE void set_sync_budget(double max_cpu_share, qulonglong max_bytes_per_s);
+    /// Null until initialize() has created the client.
+    std::shared_ptr<ClientBackend> get_client() { return _client; }
+    /// The thread the client runs on; long client calls belong there rather than on the GUI thread.
+    fc::thread& bitshares_thread() { return _bitshares_thread; }
+    /** Rescans the chain from the given block to the head for the open wallet's transactions.
+        The blocks are read in batches on the bitshares thread and matched against the wallet's
+        addresses on wallet/rescan_threads threads (one per core by default, see WalletRescanner);
+        only the matches are then added to the wallet, in chain order, on the bitshares thread.
+        Reading is not parallel, so that thread's read rate bounds the rescan.
+        Blocks until done, so call it from a thread of its own. Progress is a percentage and is reported from the scanning threads.
+        Setting *cancelled stops the scan between batches of blocks, with an fc::canceled_exception and nothing added.
+    */
+    void rescan_wallet(uint32_t start_block_num, std::function<void(float)> progress = std::function<void(float)>(),
+                       const std::atomic<bool>* cancelled = nullptr);
+
+    /** Replaces the client created by initialize(). By default that is the real bts client,
+        or FakeClientBackend when started with --mock-client <script.json> in a build with
+        INCLUDE_QT_WALLET_BENCHMARKS on. Call before initialize().
+    */
+    void set_client_factory(std::function<std::shared_ptr<ClientBackend>()> factory);
+
+    /// Returns whether the previous run crashed, and marks this one as running until destroyed.
+    bool detect_crash();
+    void reset_chain_database();
+
+    /// Serve JSON-RPC on a fixed endpoint with fixed credentials instead of a random local
+    /// port and password; used by the headless daemon. Call before initialize().
+    void set_rpc_access(const fc::ip::endpoint& httpd_endpoint, const std::string& user, const std::string& password);
 
 public Q_SLOTS:
     void set_data_dir(QString data_dir);
     void confirm_and_set_approval(QString delegate_name, bool approve);
+    /// A JSON-RPC request (or batch) sent over HTTP succeeded; lets the account roster catch up with it.
+    void rpc_request_succeeded(QByteArray request);
+    /// The web GUI sent a JSON-RPC request over HTTP, or got its answer; catch-up gives way meanwhile.
+    void interactive_call_started();
+    void interactive_call_finished();
 
   Q_SIGNALS:
     void initialized();
     void status_update(QString statusString);
     void error(QString errorString);
+    /// The web GUI asked to change a delegate's approval; whoever shows the confirmation calls wallet_approve.
+    void approval_confirmation_requested(QString delegate_name, bool approve);
+    /// Answer to find_block; the number is -1 if there is no such block.
+    void block_found(QString block_id, qint64 block_num);
+    void account_roster_changed();
+    /// Emitted from the bitshares thread with every sync sample; see get_sync_stats.
+    void sync_stats_updated(QVariantMap stats);
 
   private:
     bts::client::config                  _cfg;
-    std::shared_ptr<bts::client::client> _client;
+    std::shared_ptr<ClientBackend>       _client;
+    std::function<std::shared_ptr<ClientBackend>()> _client_factory;
     fc::future<void>                     _client_done;
     fc::thread                           _bitshares_thread;
     fc::future<void>                     _init_complete;
     fc::optional<fc::ip::endpoint>       _actual_httpd_endpoint;
     QSettings                            _settings;
+    BlockCache                           _block_cache;
+    AccountRoster                        _account_roster;
+    //Accounts to read again on applied blocks, with the number of blocks left; bitshares thread only
+    std::map<std::string, uint32_t>      _unconfirmed_accounts;
+    std::unique_ptr<SyncMonitor>         _sync_monitor;
+    fc::future<void>                     _sync_sampling;
+    std::mutex                           _sync_stats_mutex;
+    QVariantMap                          _sync_stats;
+    fc::future<void>                     _catch_up;
+    SyncThrottle                         _sync_throttle;
+    bool                                 _serve_blocks = false;
 
     std::shared_ptr<bts::net::upnp_service> _upnp_service;
 
-    std::unordered_map<std::string, std::vector<char>> _web_package;
-
+    struct rpc_access
+    {
+      fc::ip::endpoint httpd_endpoint;
+      std::string      user;
+      std::string      password;
+    };
+    fc::optional<rpc_access>             _rpc_access;
+
+    WebAssetStore                        _assets;
+    bool                                 _initialized = false;
+    std::atomic<bool>                    _startup_cancelled{false};
+    float                                _replay_progress = -1;
+    bool                                 _shutdown_attempted = false;
+    bool                                 _shutdown_completed = false;
+
+    /// Throws fc::canceled_exception once cancel_startup() was called.
+    void check_startup_cancelled();
+    /// Runs one JSON-RPC call on the bitshares thread and returns its response object as JSON.
+    fc::variant_object invoke(const std::string& method, const fc::variants& params);
     void get_htdocs_file(const fc::path& filename, const fc::http::server::response& r);
+    /// @name Account roster upkeep, on the bitshares thread
+    /// @{
+    void load_account_roster();
+    /// After a successful call that may have changed the wallet's accounts.
+    void update_account_roster(const std::string& method, const fc::variants& params);
+    void refresh_unconfirmed_accounts();
+    /// @}
+    /// Takes a sync sample and schedules the next one; on the bitshares thread.
+    void sample_sync(fc::microseconds interval);
+    /** Downloads the blocks between the head and the highest head among the sources (another
+        wallet's HTTP server, see sync/serve_blocks) through a BlockPipeline, applying them
+        alongside the client's own sync; on the bitshares thread.
+    */
+    void catch_up(const std::vector<std::string>& sources, BlockPipeline::config pipelining);
+    /// Applies a block, then waits as the sync budgets require, once push_block has returned.
+    void push_block_paced(const bts::blockchain::full_block& block);
 };
@@ -0,0 +1,117 @@
+#include "CommandClient.hpp"
+#include "SingleInstanceServer.hpp"
+
+#include <bts/blockchain/config.hpp>
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QLocalSocket>
+#include <QStringList>
+#include <QtEndian>
+
+#include <algorithm>
+#include <iostream>
+
+bool CommandClient::send(const QString& command, const QJsonObject& arguments, int timeoutMs,
+                         QJsonObject& response, QString& error)
+{
+  QElapsedTimer elapsed;
+  elapsed.start();
+  auto remaining = [&] { return std::max<int>(0, timeoutMs - elapsed.elapsed()); };
+  QLocalSocket socket;
+  //A wait given no time left returns at once, failing with whatever error the socket last had
+  auto timedOut = [&](const QString& step) {
+    error = QStringLiteral("Timed out after %1 ms %2").arg(timeoutMs).arg(step);
+    return false;
+  };
+  auto expired = [&] { return remaining() == 0 || socket.error() == QLocalSocket::SocketTimeoutError; };
+
+  socket.connectToServer(BTS_BLOCKCHAIN_NAME);
+  if (!socket.waitForConnected(timeoutMs)) {
+    if (expired())
+      return timedOut(QStringLiteral("connecting"));
+    error = QStringLiteral("No running instance: %1").arg(socket.errorString());
+    return false;
+  }
+
+  QJsonObject request = arguments;
+  request.insert("id", 1);
+  socket.write(SingleInstanceServer::request(command, request));
+  while (socket.bytesToWrite() > 0)
+  {
+    if (remaining() == 0)
+      return timedOut(QStringLiteral("sending the request"));
+    if (!socket.waitForBytesWritten(remaining())) {
+      if (expired())
+        return timedOut(QStringLiteral("sending the request"));
+      error = QStringLiteral("Unable to send request: %1").arg(socket.errorString());
+      return false;
+    }
+  }
+
+  QByteArray buffer;
+  for (;;)
+  {
+    if (buffer.size() >= 4)
+    {
+      quint32 size = qFromBigEndian<quint32>(reinterpret_cast<const uchar*>(buffer.constData()));
+      if (quint32(buffer.size()) >= 4 + size) {
+        QJsonDocument document = QJsonDocument::fromJson(buffer.mid(4, size));
+        if (!document.isObject()) {
+          error = QStringLiteral("Malformed response");
+          return false;
+        }
+        response = document.object();
+        return true;
+      }
+    }
+    if (remaining() == 0)
+      return timedOut(QStringLiteral("waiting for the response"));
+    if (!socket.waitForReadyRead(remaining())) {
+      if (expired())
+        return timedOut(QStringLiteral("waiting for the response"));
+      error = QStringLiteral("No response: %1").arg(socket.errorString());
+      return false;
+    }
+    buffer += socket.readAll();
+  }
+}
+
+int CommandClient::run(int& argc, char** argv)
+{
+  QCoreApplication app(argc, argv);
+  QStringList arguments = app.arguments();
+
+  int index = arguments.indexOf("--command");
+  if (index == -1 || arguments.size() <= index + 1) {
+    std::cerr << "Usage: " << argv[0] << " --command <name> [key=value ...] [--timeout ms]" << std::endl;
+    return 1;
+  }
+  QString command = arguments[index + 1];
+
+  int timeoutMs = DefaultTimeoutMs;
+  QJsonObject requestArguments;
+  for (int i = 1; i < arguments.size(); ++i)
+  {
+    if (i == index || i == index + 1)
+      continue;
+    if (arguments[i] == "--timeout" && i + 1 < arguments.size()) {
+      timeoutMs = arguments[++i].toInt();
+      continue;
+    }
+    int separator = arguments[i].indexOf('=');
+    if (separator > 0)
+      requestArguments.insert(arguments[i].left(separator), arguments[i].mid(separator + 1));
+  }
+
+  QJsonObject response;
+  QString error;
+  if (!send(command, requestArguments, timeoutMs, response, error)) {
+    std::cerr << error.toStdString() << std::endl;
+    return 2;
+  }
+
+  std::cout << QJsonDocument(response).toJson(QJsonDocument::Indented).toStdString();
+  return response.contains("error") ? 1 : 0;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <QJsonObject>
+#include <QString>
+
+/** Command line client for the local socket protocol of SingleInstanceServer. Lets scripts
+    drive and monitor a running wallet or daemon without starting a GUI:
+
+      qt_wallet --command get_status
+      qt_wallet --command open_url url=bitshares:...
+      qt_wallet --command shutdown --timeout 10000
+
+    Arguments of the form key=value are added to the request. The response is printed to
+    stdout as JSON; the exit code is 0 on success, 1 if the command failed and 2 if no
+    running instance answered in time.
+*/
+class CommandClient
+{
+  public:
+    static const int DefaultTimeoutMs = 5000;
+
+    static int run(int& argc, char** argv);
+
+    /// Sends one request and waits for its response; returns false with an error message on failure.
+    static bool send(const QString& command, const QJsonObject& arguments, int timeoutMs,
+                     QJsonObject& response, QString& error);
+};
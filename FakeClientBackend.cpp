@@ -0,0 +1,345 @@
+#include "FakeClientBackend.hpp"
+
+#include <bts/blockchain/balance_operations.hpp>
+
+#include <fc/io/json.hpp>
+#include <fc/reflect/variant.hpp>
+#include <fc/thread/thread.hpp>
+
+#include <algorithm>
+#include <fstream>
+
+FakeClientBackend::script FakeClientBackend::load_script(const fc::path& script_file)
+{
+  //Start from the defaults so a script only needs the keys it changes
+  fc::mutable_variant_object merged(fc::variant(script()).get_object());
+  for (const auto& entry : fc::json::from_file(script_file).get_object())
+    merged[entry.key()] = entry.value();
+  return fc::variant(merged).as<script>();
+}
+
+namespace
+{
+/// Stands in for the address of the n-th key; the wallet's keys are the first account_count.
+bts::blockchain::address fake_address(uint64_t n)
+{
+  bts::blockchain::address address;
+  address.addr = fc::ripemd160::hash(reinterpret_cast<const char*>(&n), sizeof(n));
+  return address;
+}
+} // anonymous
+
+FakeClientBackend::FakeClientBackend(script s)
+  : _script(std::move(s))
+{
+}
+
+void FakeClientBackend::call_latency()
+{
+  if (_script.call_ms)
+    fc::usleep(fc::milliseconds(_script.call_ms));
+}
+
+void FakeClientBackend::open(const fc::path& data_dir, replay_progress_callback replay_progress)
+{
+  _data_dir = data_dir;
+  fc::usleep(fc::milliseconds(_script.open_ms));
+
+  //Reports progress once per percent, like the real replay
+  uint32_t reported = 0;
+  for (uint32_t block = 1; block <= _script.replay_blocks; ++block)
+  {
+    if (_script.replay_us_per_block)
+      fc::usleep(fc::microseconds(_script.replay_us_per_block));
+    uint32_t percent = uint64_t(block) * 100 / _script.replay_blocks;
+    if (percent != reported && replay_progress)
+    {
+      reported = percent;
+      replay_progress(float(percent));
+    }
+  }
+}
+
+fc::optional<fc::ip::endpoint> FakeClientBackend::start_http_server(const bts::rpc::rpc_server::config& config,
+                                                                    http_file_callback file_callback)
+{
+  _httpd = std::make_shared<fc::http::server>();
+  _httpd->listen(config.httpd_endpoint);
+  _httpd->on_request([this, file_callback](const fc::http::request& request, const fc::http::server::response& response) {
+    if (request.path == "/rpc" || request.path == "/rpc/")
+      return handle_rpc(request, response);
+
+    std::string path = request.path;
+    path.erase(0, path.find_first_not_of('/'));
+    file_callback(fc::path(path), response);
+  });
+  return _httpd->get_local_endpoint();
+}
+
+void FakeClientBackend::handle_rpc(const fc::http::request& request, const fc::http::server::response& response)
+{
+  fc::variant id;
+  fc::variant result;
+  try
+  {
+    fc::variant_object rpc_request = fc::json::from_string(std::string(request.body.begin(), request.body.end())).get_object();
+    if (rpc_request.contains("id"))
+      id = rpc_request["id"];
+    fc::variants params;
+    if (rpc_request.contains("params"))
+      params = rpc_request["params"].get_array();
+    result = call(rpc_request.contains("method") ? rpc_request["method"].as_string() : std::string(), params);
+  }
+  catch (const fc::exception& e)
+  {
+    response.set_status(fc::http::reply::BadRequest);
+    std::string error = e.to_string();
+    response.set_length(error.size());
+    response.write(error.c_str(), error.size());
+    return;
+  }
+
+  std::string body = fc::json::to_string(fc::mutable_variant_object("id", id)("result", result));
+  response.add_header("Content-Type", "application/json");
+  response.set_status(fc::http::reply::OK);
+  response.set_length(body.size());
+  response.write(body.c_str(), body.size());
+}
+
+const bts::client::config& FakeClientBackend::configure(const fc::path& data_dir)
+{
+  return _config;
+}
+
+fc::ip::endpoint FakeClientBackend::listen()
+{
+  return fc::ip::endpoint::from_string("127.0.0.1:0");
+}
+
+fc::future<void> FakeClientBackend::start()
+{
+  fc::usleep(fc::milliseconds(_script.start_ms));
+  _stopped = fc::promise<void>::ptr(new fc::promise<void>("fake client"));
+  _started = fc::time_point::now();
+  return fc::future<void>(_stopped);
+}
+
+void FakeClientBackend::stop()
+{
+  fc::usleep(fc::milliseconds(_script.stop_ms));
+  if (_stopped && !_stopped->ready())
+    _stopped->set_value();
+  _httpd.reset();
+}
+
+void FakeClientBackend::close_chain()
+{
+  _block_applied = block_applied_callback();
+  fc::usleep(fc::milliseconds(_script.close_ms));
+}
+
+fc::variant_object FakeClientBackend::get_info()
+{
+  call_latency();
+  return fc::mutable_variant_object
+      ("blockchain_head_block_num", blockchain_head_block_num())
+      ("blockchain_head_block_age", _script.head_block_age_s)
+      ("wallet_open", _wallet_open)
+      ("wallet_unlocked", is_wallet_unlocked())
+      ("client_version", "fake");
+}
+
+fc::variant FakeClientBackend::call(const std::string& method, const fc::variants& params)
+{
+  if (method == "get_info")
+    return get_info();
+  call_latency();
+  return std::string(_script.rpc_result_bytes, 'x');
+}
+
+std::vector<std::string> FakeClientBackend::wallet_list()
+{
+  call_latency();
+  return _script.wallet_names;
+}
+
+void FakeClientBackend::wallet_open(const std::string& wallet_name)
+{
+  call_latency();
+  if (std::find(_script.wallet_names.begin(), _script.wallet_names.end(), wallet_name) == _script.wallet_names.end())
+    FC_THROW("No wallet named ${name}", ("name", wallet_name));
+  _wallet_open = true;
+}
+
+void FakeClientBackend::wallet_close()
+{
+  call_latency();
+  _wallet_open = false;
+  _wallet_unlocked = false;
+}
+
+void FakeClientBackend::wallet_unlock(const std::string& passphrase)
+{
+  call_latency();
+  FC_ASSERT(_wallet_open, "Wallet is not open");
+  FC_ASSERT(passphrase == _script.wallet_passphrase, "Invalid passphrase");
+  _wallet_unlocked = true;
+}
+
+std::vector<bts::wallet::wallet_account_record> FakeClientBackend::wallet_list_accounts()
+{
+  call_latency();
+  std::vector<bts::wallet::wallet_account_record> accounts(_script.account_count);
+  for (uint32_t i = 0; i < accounts.size(); ++i)
+  {
+    accounts[i].name = "account-" + std::to_string(i);
+    accounts[i].is_my_account = true;
+  }
+  return accounts;
+}
+
+fc::optional<bts::wallet::wallet_account_record> FakeClientBackend::wallet_get_account(const std::string& account_name)
+{
+  //wallet_list_accounts adds the latency
+  fc::optional<bts::wallet::wallet_account_record> account;
+  for (const auto& record : wallet_list_accounts())
+    if (record.name == account_name)
+      account = record;
+  return account;
+}
+
+fc::ecc::compact_signature FakeClientBackend::wallet_sign_hash(const std::string& signer, const fc::sha256& hash)
+{
+  call_latency();
+  return fc::ecc::private_key::regenerate(fc::sha256::hash(signer)).sign_compact(hash);
+}
+
+void FakeClientBackend::wallet_approve(const std::string& account_name, bool approve)
+{
+  call_latency();
+}
+
+void FakeClientBackend::wallet_scan_transaction(const std::string& transaction_id)
+{
+  call_latency();
+}
+
+void FakeClientBackend::wallet_backup_create(const fc::path& json_filename)
+{
+  call_latency();
+  std::ofstream backup(json_filename.generic_string());
+  backup << '"' << std::string(_script.backup_bytes, 'x') << '"';
+}
+
+void FakeClientBackend::wallet_backup_restore(const fc::path& json_filename, const std::string& wallet_name,
+                                              const std::string& passphrase)
+{
+  call_latency();
+  FC_ASSERT(passphrase == _script.wallet_passphrase, "Invalid passphrase");
+  if (std::find(_script.wallet_names.begin(), _script.wallet_names.end(), wallet_name) == _script.wallet_names.end())
+    _script.wallet_names.push_back(wallet_name);
+  _wallet_open = true;
+}
+
+std::unordered_set<bts::blockchain::address> FakeClientBackend::wallet_addresses()
+{
+  call_latency();
+  FC_ASSERT(_wallet_open, "Wallet is not open");
+  std::unordered_set<bts::blockchain::address> addresses;
+  for (uint64_t i = 0; i < _script.account_count; ++i)
+    addresses.insert(fake_address(i));
+  return addresses;
+}
+
+fc::optional<bts::blockchain::account_record> FakeClientBackend::blockchain_get_account(const std::string& account_name)
+{
+  call_latency();
+  bts::blockchain::account_record account;
+  account.name = account_name;
+  //Names like delegate-3 are delegates, so approval flows can be exercised
+  if (account_name.compare(0, 8, "delegate") == 0)
+    account.delegate_info = bts::blockchain::delegate_stats();
+  return account;
+}
+
+fc::optional<bts::blockchain::account_record> FakeClientBackend::blockchain_get_account(const bts::blockchain::address& owner)
+{
+  call_latency();
+  return fc::optional<bts::blockchain::account_record>();
+}
+
+bts::blockchain::digest_block FakeClientBackend::blockchain_get_block_digest(const bts::blockchain::block_id_type& block_id)
+{
+  call_latency();
+  bts::blockchain::digest_block digest;
+  digest.block_num = block_id._hash[0] % (_script.head_block_num + 1);
+  return digest;
+}
+
+std::vector<bts::blockchain::signed_transaction> FakeClientBackend::blockchain_get_block_transactions(uint32_t block_num)
+{
+  if (_script.block_read_us)
+    fc::usleep(fc::microseconds(_script.block_read_us));
+
+  std::vector<bts::blockchain::signed_transaction> transactions(_script.transactions_per_block);
+  for (uint32_t i = 0; i < transactions.size(); ++i)
+  {
+    uint64_t n = uint64_t(block_num) * transactions.size() + i;
+    auto to_wallet = [this](uint64_t n) {
+      return bts::blockchain::deposit_operation(fake_address(n / 1000 % std::max<uint32_t>(1, _script.account_count)),
+                                                bts::blockchain::asset(1));
+    };
+    transactions[i].expiration = fc::time_point_sec(block_num);
+    if (n % 1000 == 500)
+      transactions[i].operations.push_back(bts::blockchain::withdraw_operation(to_wallet(n - 500).condition.get_address(), 1));
+    transactions[i].operations.push_back(n % 1000 == 0 ? to_wallet(n)
+                                                       : bts::blockchain::deposit_operation(fake_address(~n), bts::blockchain::asset(1)));
+  }
+  return transactions;
+}
+
+double FakeClientBackend::seconds_running() const
+{
+  return _started ? (fc::time_point::now() - *_started).count() / 1000000.0 : 0;
+}
+
+uint32_t FakeClientBackend::blockchain_head_block_num()
+{
+  return std::max(_pushed_head, _script.head_block_num + uint32_t(seconds_running() * _script.sync_blocks_per_s));
+}
+
+std::vector<bts::blockchain::full_block> FakeClientBackend::blockchain_get_blocks(uint32_t first_block, uint32_t count)
+{
+  uint32_t last = uint32_t(std::min<uint64_t>(uint64_t(first_block) + count, uint64_t(blockchain_head_block_num()) + 1));
+  std::vector<bts::blockchain::full_block> blocks;
+  for (uint32_t block_num = std::max<uint32_t>(1, first_block); block_num < last; ++block_num)
+  {
+    blocks.emplace_back();
+    blocks.back().block_num = block_num;
+    blocks.back().user_transactions = blockchain_get_block_transactions(block_num);
+  }
+  return blocks;
+}
+
+void FakeClientBackend::blockchain_push_block(const bts::blockchain::full_block& block)
+{
+  FC_ASSERT(block.block_num == blockchain_head_block_num() + 1, "Block ${num} doesn't follow the head", ("num", block.block_num));
+  if (_script.block_apply_us)
+    fc::usleep(fc::microseconds(_script.block_apply_us));
+  _pushed_head = block.block_num;
+  if (_block_applied)
+    _block_applied(block.id(), bts::blockchain::digest_block(block));
+}
+
+std::vector<ClientBackend::peer_traffic> FakeClientBackend::network_get_peer_traffic()
+{
+  call_latency();
+  std::vector<peer_traffic> traffic(_script.sync_peers);
+  for (uint32_t i = 0; i < traffic.size(); ++i)
+  {
+    traffic[i].endpoint = "127.0.0." + std::to_string(i + 1) + ":1776";
+    traffic[i].bytes_received = uint64_t(seconds_running() * _script.sync_bytes_per_s / traffic.size());
+    traffic[i].bytes_sent = traffic[i].bytes_received / 50;
+  }
+  return traffic;
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "ClientBackend.hpp"
+
+#include <fc/reflect/reflect.hpp>
+#include <fc/thread/thread.hpp>
+
+/** In-process stand-in for the real client, for benchmarking ClientWrapper and MainWindow on
+    a machine without a chain directory or network peers. Every call sleeps for its scripted
+    latency (cooperatively, like a real call waiting on I/O) and returns synthetic data of the
+    scripted size. It serves JSON-RPC itself, over HTTP and through call(): get_info is answered
+    from the fake state and any other method with a string of rpc_result_bytes characters.
+
+    Selected with --mock-client <script.json>; keys missing from the script keep their defaults.
+*/
+class FakeClientBackend : public ClientBackend
+{
+public:
+  struct script
+  {
+    uint32_t replay_blocks = 0;
+    uint32_t replay_us_per_block = 0;
+    uint32_t open_ms = 0;
+    uint32_t start_ms = 0;
+    uint32_t stop_ms = 0;
+    uint32_t close_ms = 0;
+    /// Cost of reading one block from the chain, for rescans.
+    uint32_t block_read_us = 0;
+    /// Cost of applying one block during catch-up sync.
+    uint32_t block_apply_us = 0;
+    /// Latency of get_info, wallet calls and JSON-RPC requests.
+    uint32_t call_ms = 0;
+    uint32_t rpc_result_bytes = 256;
+    uint32_t account_count = 1;
+    uint32_t backup_bytes = 64 * 1024;
+    uint32_t head_block_num = 1000000;
+    uint32_t head_block_age_s = 0;
+    /// Once started, the head advances this fast, as if catching up.
+    uint32_t sync_blocks_per_s = 0;
+    /// Connected peers, sharing sync_bytes_per_s of download between them.
+    uint32_t sync_peers = 0;
+    uint32_t sync_bytes_per_s = 0;
+    /// Every transaction is a deposit; one in a thousand goes to one of the wallet's accounts, and
+    /// the one 500 transactions later spends it again, withdrawing it to someone else.
+    uint32_t transactions_per_block = 0;
+    std::vector<std::string> wallet_names = {"default"};
+    std::string wallet_passphrase = "password";
+  };
+
+  static script load_script(const fc::path& script_file);
+
+  explicit FakeClientBackend(script s = script());
+
+  virtual void open(const fc::path& data_dir, replay_progress_callback replay_progress) override;
+  virtual bool is_wallet_enabled() override { return true; }
+  virtual fc::optional<fc::ip::endpoint> start_http_server(const bts::rpc::rpc_server::config& config,
+                                                           http_file_callback file_callback) override;
+  virtual const bts::client::config& configure(const fc::path& data_dir) override;
+  virtual void init_cli() override {}
+  virtual fc::ip::endpoint listen() override;
+  virtual fc::future<void> start() override;
+  /// There is no network to start, but the seeds are dialed all the same, so the dialing can be tried on stand-in peers.
+  virtual void start_networking(std::function<void()> connect_to_seeds) override { fc::async(connect_to_seeds, "connect to seeds"); }
+  virtual void connect_to_peer(const std::string& peer) override { call_latency(); }
+  virtual std::vector<peer_traffic> network_get_peer_traffic() override;
+
+  virtual void stop() override;
+  virtual void close_chain() override;
+
+  virtual fc::variant_object get_info() override;
+  virtual fc::variant call(const std::string& method, const fc::variants& params) override;
+
+  virtual std::vector<std::string> wallet_list() override;
+  virtual void wallet_open(const std::string& wallet_name) override;
+  virtual void wallet_close() override;
+  virtual bool is_wallet_open() override { return _wallet_open; }
+  virtual bool is_wallet_unlocked() override { return _wallet_open && _wallet_unlocked; }
+  virtual void wallet_unlock(const std::string& passphrase) override;
+  virtual void wallet_lock() override { _wallet_unlocked = false; }
+  virtual fc::path wallet_data_directory() override { return _data_dir / "wallets"; }
+  virtual std::vector<bts::wallet::wallet_account_record> wallet_list_accounts() override;
+  virtual fc::optional<bts::wallet::wallet_account_record> wallet_get_account(const std::string& account_name) override;
+  virtual fc::ecc::compact_signature wallet_sign_hash(const std::string& signer, const fc::sha256& hash) override;
+  virtual void wallet_approve(const std::string& account_name, bool approve) override;
+  virtual void wallet_scan_transaction(const std::string& transaction_id) override;
+  virtual void wallet_backup_create(const fc::path& json_filename) override;
+  virtual void wallet_backup_restore(const fc::path& json_filename, const std::string& wallet_name,
+                                     const std::string& passphrase) override;
+  virtual std::unordered_set<bts::blockchain::address> wallet_addresses() override;
+
+  virtual fc::optional<bts::blockchain::account_record> blockchain_get_account(const std::string& account_name) override;
+  virtual fc::optional<bts::blockchain::account_record> blockchain_get_account(const bts::blockchain::address& owner) override;
+  virtual bts::blockchain::digest_block blockchain_get_block_digest(const bts::blockchain::block_id_type& block_id) override;
+  /// The fake chain only grows by blockchain_push_block, so those are the only blocks called back for.
+  virtual void subscribe_to_blocks(block_applied_callback callback) override { _block_applied = callback; }
+  virtual uint32_t blockchain_head_block_num() override;
+  virtual std::vector<bts::blockchain::signed_transaction> blockchain_get_block_transactions(uint32_t block_num) override;
+  /// The fake chain keeps no balances, as if all had been spent, so every owner is unknown.
+  virtual std::vector<fc::optional<bts::blockchain::address>>
+  blockchain_get_balance_owners(const std::vector<bts::blockchain::balance_id_type>& balance_ids) override
+  {
+    return std::vector<fc::optional<bts::blockchain::address>>(balance_ids.size());
+  }
+  /// Blocks with the transactions of blockchain_get_block_transactions, up to the head.
+  virtual std::vector<bts::blockchain::full_block> blockchain_get_blocks(uint32_t first_block, uint32_t count) override;
+  /// Only checks the block follows the head, which it then becomes.
+  virtual void blockchain_push_block(const bts::blockchain::full_block& block) override;
+
+private:
+  script                             _script;
+  fc::path                           _data_dir;
+  bts::client::config                _config;
+  std::shared_ptr<fc::http::server>  _httpd;
+  fc::promise<void>::ptr             _stopped;
+  bool                               _wallet_open = false;
+  bool                               _wallet_unlocked = false;
+  fc::optional<fc::time_point>       _started;
+  /// Highest block pushed, once above the scripted head.
+  uint32_t                           _pushed_head = 0;
+  block_applied_callback             _block_applied;
+
+  /// Seconds since start(), for the scripted sync.
+  double seconds_running() const;
+
+  void call_latency();
+  void handle_rpc(const fc::http::request& request, const fc::http::server::response& response);
+};
+
+FC_REFLECT(FakeClientBackend::script,
+           (replay_blocks)(replay_us_per_block)(open_ms)(start_ms)(stop_ms)(close_ms)(block_read_us)(block_apply_us)(call_ms)
+           (rpc_result_bytes)(account_count)(backup_bytes)(head_block_num)(head_block_age_s)
+           (sync_blocks_per_s)(sync_peers)(sync_bytes_per_s)(transactions_per_block)
+           (wallet_names)(wallet_passphrase))
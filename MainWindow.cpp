@@ -18,8 +18,8 @@
 #include <QFormLayout>
 #include <QNetworkReply>
 #include <QFileDialog>
+#include <QProgressDialog>
 #include <QClipboard>
-#include <QGraphicsWebView>
 #include <QWebFrame>
 #include <QDir>
 #include <QTimer>
@@ -35,9 +35,7 @@
 #include <bts/blockchain/account_record.hpp>
 #include <bts/utilities/git_revision.hpp>
 
-#include <fc/io/raw_variant.hpp>
 #include <fc/io/fstream.hpp>
-#include <fc/compress/lzma.hpp>
 
 #ifdef __APPLE__
 #include <Carbon/Carbon.h>
@@ -53,18 +51,11 @@ MainWindow::MainWindow()
   initMenu();
 
   version = bts::utilities::git_revision_description;
-  // for an official release, git_revision_description is the git tag, which will
-  // look like bts/0.4.28 or dvs/0.4.29
-  QRegExp versionMatcher(".*/(\\d+)\\.(\\d+)\\.(\\d+)(-([a-z]))?");
-  versionMatcher.indexIn(version);
-  if (versionMatcher.pos(3) != -1)
-  {
-    _majorVersion = versionMatcher.cap(1).toInt();
-    _forkVersion = versionMatcher.cap(2).toInt();
-    _minorVersion = versionMatcher.cap(3).toInt();
-  }
-  if (versionMatcher.pos(5) != -1)
-    _patchVersion = versionMatcher.cap(5).toStdString()[0];
+  ClientVersion running = parseClientVersion(version);
+  _majorVersion = running.majorVersion;
+  _forkVersion = running.forkVersion;
+  _minorVersion = running.minorVersion;
+  _patchVersion = running.patchVersion;
 
   //Check every 20 minutes
   _updateChecker->setInterval(1200000);
@@ -159,7 +150,7 @@ void MainWindow::processCustomUrl(QString url)
     }
     
     
-    QString urlStr = QString::fromStdString("http://" + std::string( *(clientWrapper()->get_httpd_endpoint()) ) + "/#");
+    QString urlStr = ClientWrapper::ui_origin() + "/#";
     QString str = components[0].toLower();
     
     if(str == "home"  || str == "delegates" || str == "notes" || str =="directory" || str =="newcontact" ||
@@ -214,6 +205,26 @@ ClientWrapper *MainWindow::clientWrapper() const
 void MainWindow::setClientWrapper(ClientWrapper *clientWrapper)
 {
   _clientWrapper = clientWrapper;
+  connect(_clientWrapper, &ClientWrapper::approval_confirmation_requested, this, &MainWindow::confirmAndSetApproval);
+  connect(_clientWrapper, &ClientWrapper::block_found, this, &MainWindow::blockFound);
+}
+
+void MainWindow::confirmAndSetApproval(QString delegateName, bool approve)
+{
+  auto account = clientWrapper()->get_client()->blockchain_get_account(delegateName.toStdString());
+  if( account.valid() && account->is_delegate() )
+  {
+    if( QMessageBox::question(this,
+                              tr("Set Delegate Approval"),
+                              tr("Would you like to update approval rating of Delegate %1 to %2?")
+                              .arg(delegateName)
+                              .arg(approve?"Approve":"Disapprove")
+                              )
+        == QMessageBox::Yes )
+      clientWrapper()->get_client()->wallet_approve(delegateName.toStdString(), approve);
+  }
+  else
+    QMessageBox::warning(this, tr("Invalid Account"), tr("Account %1 is not a delegate, so its approval cannot be set.").arg(delegateName));
 }
 
 void MainWindow::navigateTo(const QString& path)
@@ -224,22 +235,12 @@ void MainWindow::navigateTo(const QString& path)
   }
 }
 
-bool MainWindow::detectCrash()
-{
-  QString crashState = _settings.value("crash_state", "no_crash").toString();
-
-  //Set to crashed for the duration of execution; ClientWrapper::close sets it back before exiting
-  _settings.setValue("crash_state", "crashed");
-
-  return crashState == "crashed";
-}
-
 void MainWindow::goToHomepage()
 {
     //navigateTo("/home");
     if( walletIsUnlocked() ) {
         
-        QUrl url = QString::fromStdString("http://" + std::string( *(clientWrapper()->get_httpd_endpoint()) ) + "/#/home" );
+        QUrl url = ClientWrapper::ui_origin() + "/#/home";
         
         getViewer()->webView()->load(url);
     }
@@ -362,7 +363,23 @@ void MainWindow::goToBlock(uint32_t blockNumber)
 
 void MainWindow::goToBlock(QString blockId)
 {
-  bool error = false;
+  //Answered by blockFound; only the latest request is followed
+  _requestedBlockId = blockId;
+  _clientWrapper->find_block(blockId);
+}
+
+void MainWindow::blockFound(QString blockId, qint64 blockNumber)
+{
+  if( blockId != _requestedBlockId )
+    return;
+  _requestedBlockId.clear();
+
+  if( blockNumber >= 0 )
+  {
+    goToBlock(uint32_t(blockNumber));
+    return;
+  }
+
   QMessageBox errorDialog(this);
   errorDialog.setIcon(QMessageBox::Warning);
   errorDialog.addButton(QMessageBox::Ok);
@@ -370,19 +387,7 @@ void MainWindow::goToBlock(QString blockId)
   errorDialog.setWindowModality(Qt::WindowModal);
   errorDialog.setWindowTitle(tr("Cannot Open Transaction"));
   errorDialog.setText(tr("The specified block ID does not exist."));
-
-  try
-  {
-    auto block = _clientWrapper->get_client()->get_chain()->get_block_digest(bts::blockchain::block_id_type(blockId.toStdString()));
-    goToBlock(block.block_num);
-  }
-  catch(...)
-  {
-    error = true;
-  }
-
-  if (error)
-    errorDialog.exec();
+  errorDialog.exec();
 }
 
 void MainWindow::goToTransaction(QString transactionId)
@@ -448,9 +453,9 @@ Html5Viewer* MainWindow::getViewer()
 
 bool MainWindow::walletIsUnlocked(bool promptToUnlock)
 {
-  if( !_clientWrapper || !_clientWrapper->get_client()->get_wallet()->is_open() )
+  if( !_clientWrapper || !_clientWrapper->get_client() || !_clientWrapper->get_client()->is_wallet_open() )
     return false;
-  if( _clientWrapper->get_client()->get_wallet()->is_unlocked() )
+  if( _clientWrapper->get_client()->is_wallet_unlocked() )
     return true;
 
   bool badPassword = false;
@@ -471,7 +476,7 @@ bool MainWindow::walletIsUnlocked(bool promptToUnlock)
     {
       try
       {
-        _clientWrapper->get_client()->get_wallet()->unlock( password.toStdString(), BTS_WALLET_DEFAULT_UNLOCK_TIME_SEC );
+        _clientWrapper->get_client()->wallet_unlock( password.toStdString() );
         promptToUnlock = false;
       }
       catch (...)
@@ -481,12 +486,12 @@ bool MainWindow::walletIsUnlocked(bool promptToUnlock)
     }
   }
 
-  return _clientWrapper->get_client()->get_wallet()->is_unlocked();
+  return _clientWrapper->get_client()->is_wallet_unlocked();
 }
 
 std::string MainWindow::getLoginUser(const fc::ecc::public_key& serverKey)
 {
-  auto serverAccount = _clientWrapper->get_client()->get_chain()->get_account_record(serverKey);
+  auto serverAccount = _clientWrapper->get_client()->blockchain_get_account(bts::blockchain::address(serverKey));
   if( !serverAccount.valid() )
   {
     uint64_t head_block_age( -1 );
@@ -515,28 +520,28 @@ std::string MainWindow::getLoginUser(const fc::ecc::public_key& serverKey)
   userSelecterDialog.setWindowModality(Qt::WindowModal);
 
   QStringList accounts;
-  auto wallet_accounts = _clientWrapper->get_client()->wallet_list_accounts();
+  auto wallet_accounts = _clientWrapper->account_roster().names();
   if( wallet_accounts.size() == 1 )
   {
     QMessageBox loginAuthBox(QMessageBox::Question,
                              tr("Login"),
                              tr("You are about to log in to %1 as %2. Would you like to continue?")
                                 .arg(serverName)
-                                .arg(wallet_accounts[0].name.c_str()),
+                                .arg(wallet_accounts[0].c_str()),
                              QMessageBox::Yes | QMessageBox::No,
                              this);
     loginAuthBox.setDefaultButton(QMessageBox::Yes);
     loginAuthBox.setWindowModality(Qt::WindowModal);
     if( loginAuthBox.exec() == QMessageBox::Yes )
-      return wallet_accounts[0].name;
+      return wallet_accounts[0];
     else
       return std::string();
   }
   if( wallet_accounts.size() == 0 )
     return "EMPTY";
 
-  for( auto account : wallet_accounts )
-    accounts.push_back(account.name.c_str());
+  for( const auto& account : wallet_accounts )
+    accounts.push_back(account.c_str());
 
   QComboBox* userSelecterBox = new QComboBox();
   QObject sentry;
@@ -698,13 +703,15 @@ void MainWindow::closeEvent( QCloseEvent* event )
 
 void MainWindow::importWallet()
 {
-  QString walletPath = QFileDialog::getOpenFileName(this, tr("Import Wallet"), QDir::homePath(), tr("Wallet Backups (*.json)"));
-  if( walletPath.isNull() || !QFileInfo(walletPath).exists() )
+  if( _walletImport ) {
+    QMessageBox::information(this, tr("Import Wallet"), tr("A wallet backup is already being restored."));
     return;
+  }
 
-  clientWrapper()->get_client()->wallet_close();
+  QString walletPath = QFileDialog::getOpenFileName(this, tr("Import Wallet"), QDir::homePath(), tr("Wallet Backups (*.json *.json.gz)"));
+  if( walletPath.isNull() || !QFileInfo(walletPath).exists() )
+    return;
 
-  QDir default_wallet_directory = QString::fromStdWString(clientWrapper()->get_client()->get_wallet()->get_data_directory().generic_wstring());
   QString default_wallet_name = _settings.value("client/default_wallet_name").toString();
 
   if( QMessageBox::warning(this,
@@ -716,8 +723,6 @@ void MainWindow::importWallet()
       != 0)
     return;
 
-  QString backup_wallet_name = default_wallet_name + "-backup-" + QDateTime::currentDateTime().toString(Qt::ISODate).replace(':', "");
-
   bool ok = false;
   QString password = QInputDialog::getText(this,
                                            tr("Import Wallet Passphrase"),
@@ -725,25 +730,113 @@ void MainWindow::importWallet()
                                            QLineEdit::Password,
                                            QString(),
                                            &ok);
-  if(ok) {
-    if( default_wallet_directory.exists(default_wallet_name) )
-      default_wallet_directory.rename(default_wallet_name, backup_wallet_name);
-    try {
-      clientWrapper()->get_client()->wallet_backup_restore(walletPath.toStdWString(),
-                                                           default_wallet_name.toStdString(),
-                                                           password.toStdString());
-    } catch (const fc::exception& e) {
-      if( default_wallet_directory.exists(default_wallet_name) )
-        QDir(default_wallet_directory.absoluteFilePath(default_wallet_name)).removeRecursively();
-      if( default_wallet_directory.exists(backup_wallet_name) )
-        default_wallet_directory.rename(backup_wallet_name, default_wallet_name);
+  if( !ok )
+    return;
+
+  _walletImport = new WalletBackupImport(_clientWrapper, walletPath, default_wallet_name, password, this);
+  QPointer<QProgressDialog> progress = new QProgressDialog(this);
+  progress->setWindowTitle(tr("Import Wallet"));
+  progress->setCancelButton(nullptr);
+  progress->setRange(0, 0);
+  progress->setWindowModality(Qt::NonModal);
+  progress->setAttribute(Qt::WA_DeleteOnClose);
+  progress->show();
+
+  connect(_walletImport.data(), &WalletBackupImport::phaseChanged, this, [this, progress](int phase) {
+    QString label;
+    switch( phase ) {
+    case WalletBackupImport::Parsing:
+      label = tr("Reading wallet backup...");
+      break;
+    case WalletBackupImport::Restoring:
+      //The wallet is closed and replaced in this phase; keep the GUI from calling into it meanwhile
+      getViewer()->setEnabled(false);
+      label = tr("Restoring keys and accounts...");
+      break;
+    case WalletBackupImport::Rescanning:
+      getViewer()->setEnabled(true);
+      getViewer()->loadUrl(clientWrapper()->http_url());
+      label = tr("Scanning the blockchain for your transactions. You can keep using the wallet meanwhile...");
+      if( progress )
+        progress->setRange(0, 100);
+      break;
+    }
+    if( progress )
+      progress->setLabelText(label);
+  });
+  connect(_walletImport.data(), &WalletBackupImport::rescanProgress, this, [progress](int percent) {
+    if( progress )
+      progress->setValue(percent);
+  });
+  auto finish = [this, progress] {
+    if( progress )
+      progress->close();
+    getViewer()->setEnabled(true);
+    _walletImport->deleteLater();
+  };
+  connect(_walletImport.data(), &WalletBackupImport::succeeded, this, finish);
+  connect(_walletImport.data(), &WalletBackupImport::failed, this, [this, finish](int phase, QString error) {
+    finish();
+    //Cancelled, which only happens on the way out
+    if( error.isNull() )
+      return;
+    switch( phase ) {
+    case WalletBackupImport::Parsing:
+      QMessageBox::critical(this, tr("Wallet Restore Failed"),
+                            tr("The wallet backup could not be read, and your wallet was not changed. Error: %1").arg(error));
+      break;
+    case WalletBackupImport::Restoring:
       QMessageBox::critical(this,
                             tr("Wallet Restore Failed"),
-                            tr("Failed to restore wallet backup. Your original wallet has been restored. Error: %1If you are sure that your password and backup file are correct, please post a support request here: https://bitsharestalk.org/index.php/board,45.0.html").arg(e.to_string().c_str()));
+                            tr("Failed to restore wallet backup. Your original wallet has been restored. Error: %1If you are sure that your password and backup file are correct, please post a support request here: https://bitsharestalk.org/index.php/board,45.0.html").arg(error));
+      getViewer()->loadUrl(clientWrapper()->http_url());
+      break;
+    case WalletBackupImport::Rescanning:
+      QMessageBox::warning(this, tr("Wallet Rescan Failed"),
+                           tr("Your wallet backup was restored, but scanning the blockchain for its transactions failed, so some may be missing. Error: %1").arg(error));
+      break;
     }
-  } else return;
+  });
+  _walletImport->start();
+}
+
+void MainWindow::exportWallet()
+{
+  if( _walletExport ) {
+    QMessageBox::information(this, tr("Export Wallet"), tr("The wallet is already being exported to %1.").arg(_walletExport->destination()));
+    return;
+  }
 
-  getViewer()->loadUrl(clientWrapper()->http_url());
+  QString compressedFilter = tr("Compressed Wallet Backups (*.json.gz)");
+  QString selectedFilter;
+  QString savePath = QFileDialog::getSaveFileName(this,
+                                                  tr("Export Wallet"),
+                                                  QDir::homePath().append(QStringLiteral("/%1 Wallet Backup.json").arg(qApp->applicationName())),
+                                                  tr("Wallet Backups (*.json)") + ";;" + compressedFilter,
+                                                  &selectedFilter);
+  if( savePath.isNull() )
+    return;
+  bool compress = selectedFilter == compressedFilter || savePath.endsWith(".gz");
+  if( compress && !savePath.endsWith(".gz") )
+    savePath += ".gz";
+
+  //An existing backup is only replaced once the new one is complete
+  _walletExport = new WalletBackupExport(_clientWrapper, savePath, compress, this);
+  QPointer<QProgressDialog> progress = new QProgressDialog(tr("Exporting wallet to %1...").arg(QFileInfo(savePath).fileName()),
+                                                  tr("Cancel"), 0, 100, this);
+  progress->setWindowModality(Qt::NonModal);
+  progress->setMinimumDuration(500);
+  progress->setAttribute(Qt::WA_DeleteOnClose);
+  connect(progress.data(), &QProgressDialog::canceled, _walletExport.data(), &WalletBackupExport::cancel);
+  connect(_walletExport.data(), &WalletBackupExport::progress, progress.data(), &QProgressDialog::setValue);
+  connect(_walletExport.data(), &WalletBackupExport::finished, this, [this, progress](bool success, QString error) {
+    if( progress )
+      progress->close();
+    _walletExport->deleteLater();
+    if( !success && !error.isEmpty() )
+      QMessageBox::warning(this, tr("Export Failed"), tr("Could not export the wallet: %1").arg(error));
+  });
+  _walletExport->start();
 }
 
 void MainWindow::initMenu()
@@ -753,22 +846,7 @@ void MainWindow::initMenu()
   _fileMenu = menuBar->addMenu(tr("File"));
 
   connect(_fileMenu->addAction(tr("Import Wallet")), &QAction::triggered, this, &MainWindow::importWallet);
-  connect(_fileMenu->addAction(tr("Export Wallet")), &QAction::triggered, [this](){
-    QString savePath = QFileDialog::getSaveFileName(this,
-                                                    tr("Export Wallet"),
-                                                    QDir::homePath().append(QStringLiteral("/%1 Wallet Backup.json").arg(qApp->applicationName())),
-                                                    tr("Wallet Backups (*.json)"));
-    if( !savePath.isNull() ) {
-        if( QFileInfo(savePath).exists())
-            if (!QFile::remove(savePath)) {
-                QMessageBox::warning(this,
-                                     tr("Export Failed"),
-                                     tr("Could not export wallet because the selected file already exists and cannot be removed."));
-                return;
-            }
-        _clientWrapper->get_client()->wallet_backup_create(savePath.toStdWString());
-    }
-  });
+  connect(_fileMenu->addAction(tr("Export Wallet")), &QAction::triggered, this, &MainWindow::exportWallet);
   _fileMenu->actions().last()->setShortcut(QKeySequence(tr("Ctrl+Shift+X")));
   connect(_fileMenu->addAction(tr("Open URL")), &QAction::triggered, [this]{
     QInputDialog urlGetter(this);
@@ -787,42 +865,34 @@ void MainWindow::initMenu()
   _fileMenu->addAction(tr("Change Password"))->setEnabled(false);
   _fileMenu->addAction(tr("Check for Updates"), this, SLOT(checkWebUpdates()));
   _fileMenu->addAction(tr("Remove Updates"), this, SLOT(removeWebUpdates()));
+  _fileMenu->addAction(tr("Sync Status"), this, SLOT(showSyncStatus()));
   _fileMenu->addAction(tr("Quit"), qApp, SLOT(quit()), QKeySequence(tr("Ctrl+Q")));
 
   _accountMenu = menuBar->addMenu(tr("Accounts"));
   setMenuBar(menuBar);
+
+  //Debug overlay with paint and input latency statistics of the web view; not shown in any menu.
+  QAction* frameStatsAction = new QAction(tr("Toggle Frame Statistics"), this);
+  frameStatsAction->setShortcut(QKeySequence(tr("Ctrl+Alt+F")));
+  connect(frameStatsAction, &QAction::triggered, [this] {
+    getViewer()->setFrameStatsOverlayVisible(!getViewer()->isFrameStatsOverlayVisible());
+  });
+  addAction(frameStatsAction);
 }
 
-bool MainWindow::verifyUpdateSignature (QByteArray updatePackage)
+void MainWindow::showSyncStatus()
 {
-  if (_webUpdateDescription.signatures.size() < WEB_UPDATES_SIGNATURE_REQUIREMENT
-          || WEB_UPDATES_SIGNING_KEYS.size() < WEB_UPDATES_SIGNATURE_REQUIREMENT) {
-      elog("Rejecting update signature: insufficient signatures in manifest.");
-      return false;
-  }
-  if (_webUpdateDescription.timestamp < fc::time_point_sec(bts::utilities::git_revision_unix_timestamp)) {
-      elog("Rejecting update signature: timestamp older than build.");
-      return false;
-  }
-
-  elog("The size of the update package is ${s}", ("s", updatePackage.size()));
-
-  fc::sha256::encoder enc;
-  enc.write(updatePackage.data(), updatePackage.size());
-  std::string desc = _webUpdateDescription.signable_string();
-  enc.write(desc.c_str(), desc.size());
-  auto hash = enc.result();
-
-  auto authorized_signers = WEB_UPDATES_SIGNING_KEYS;
-  for (auto signature : _webUpdateDescription.signatures)
+  if( !_syncStatus )
   {
-    authorized_signers.erase(bts::blockchain::address(fc::ecc::public_key(signature, hash, false)));
-    elog("The address of the update package is ${s}", ("s", bts::blockchain::address(fc::ecc::public_key(signature, hash, false))));
+    _syncStatus = new SyncStatusDialog(this);
+    _syncStatus->setAttribute(Qt::WA_DeleteOnClose);
+    _syncStatus->showStats(_clientWrapper->get_sync_stats());
+    connect(_clientWrapper, &ClientWrapper::sync_stats_updated, _syncStatus.data(), &SyncStatusDialog::showStats);
+    connect(_syncStatus.data(), &SyncStatusDialog::budgetChanged, _clientWrapper, &ClientWrapper::set_sync_budget);
   }
-  if ((WEB_UPDATES_SIGNING_KEYS.size() - authorized_signers.size()) >= WEB_UPDATES_SIGNATURE_REQUIREMENT)
-    return true;
-  elog("Rejecting update signature: signature requirement failed (got ${match}/${req} matches)", ("match", WEB_UPDATES_SIGNING_KEYS.size() - authorized_signers.size())("req", WEB_UPDATES_SIGNATURE_REQUIREMENT));
-  return false;
+  _syncStatus->show();
+  _syncStatus->raise();
+  _syncStatus->activateWindow();
 }
 
 void MainWindow::showNoUpdateAlert(QString info)
@@ -839,36 +909,9 @@ void MainWindow::showNoUpdateAlert(QString info)
 
 void MainWindow::checkWebUpdates(bool showNoUpdatesAlert, std::function<void()> finishedCheckCallback)
 {
-  QString queryString = QString("?uuid=%1&version=%2").arg(app_id.toString().mid(1,36), version);
-
-#if QT_VERSION >= 0x050400
-  queryString += QString("&platform=%1").arg(QSysInfo::prettyProductName());
-#endif
-
-#ifdef Q_OS_LINUX
-  queryString += QString("&os=linux");
-#elif defined(Q_OS_WIN32)
-  queryString += QString("&os=windows");
-#elif defined(Q_OS_MAC)
-  queryString += QString("&os=mac");
-#else
-  queryString += QString("&os=unknown");
-#endif
-
-  QUrl manifestUrl(WEB_UPDATES_MANIFEST_URL + queryString);
+  QUrl manifestUrl = webUpdatesManifestUrl(app_id, version);
   QDir dataDir(QString(clientWrapper()->get_data_dir()));
-
-  if (dataDir.exists("web.json") ^ dataDir.exists("web.dat"))
-  {
-    if (dataDir.exists("web.json")) {
-      elog("Found web.json but not web.dat. Deleting.");
-      dataDir.remove("web.json");
-    }
-    if (dataDir.exists("web.dat")) {
-      elog("Found web.dat but not web.json. Deleting.");
-      dataDir.remove("web.dat");
-    }
-  }
+  removeIncompleteWebUpdate(dataDir);
 
   QNetworkAccessManager* downer = new QNetworkAccessManager;
   downer->get(QNetworkRequest(manifestUrl));
@@ -883,22 +926,14 @@ void MainWindow::checkWebUpdates(bool showNoUpdatesAlert, std::function<void()>
         QByteArray data = reply->readAll();
         manifest = fc::json::from_string(std::string(data.data(), data.size())).as<WebUpdateManifest>();
 
-        WebUpdateManifest::UpdateDetails update;
-        update.majorVersion = _majorVersion;
-        update.forkVersion = _forkVersion;
-        update.minorVersion = _minorVersion + 1;
+        ClientVersion running;
+        running.majorVersion = _majorVersion;
+        running.forkVersion = _forkVersion;
+        running.minorVersion = _minorVersion;
+        running.patchVersion = _patchVersion;
 
-        auto itr = manifest.updates.lower_bound(update);
-        if (itr == manifest.updates.begin())
-        {
-          if (showNoUpdatesAlert) showNoUpdateAlert();
-          return;
-        }
-        --itr;
-        update = *itr;
-        if (update.majorVersion != _majorVersion || update.forkVersion != _forkVersion
-                || update.minorVersion != _minorVersion || update.patchVersion <= _patchVersion
-                || update.signatures.size() < WEB_UPDATES_SIGNATURE_REQUIREMENT)
+        WebUpdateManifest::UpdateDetails update;
+        if (!findWebUpdate(manifest, running, update))
         {
           if (showNoUpdatesAlert) showNoUpdateAlert();
           return;
@@ -913,7 +948,7 @@ void MainWindow::checkWebUpdates(bool showNoUpdatesAlert, std::function<void()>
       if (error && showNoUpdatesAlert) showNoUpdateAlert();
     } else {
       auto package = reply->readAll();
-      if (!verifyUpdateSignature(package)) {
+      if (!verifyWebUpdateSignature(_webUpdateDescription, package)) {
         if (showNoUpdatesAlert) showNoUpdateAlert();
         return;
       }
@@ -939,11 +974,8 @@ void MainWindow::checkWebUpdates(bool showNoUpdatesAlert, std::function<void()>
         return;
       }
 
-      QFile webPackage(dataDir.absoluteFilePath("web.dat"));
-      webPackage.open(QIODevice::WriteOnly);
-      webPackage.write(package);
-      fc::json::save_to_file(fc::variant(_webUpdateDescription), fc::path(clientWrapper()->get_data_dir().toStdWString()) / "web.json");
-      wlog("Downloaded new web package.");
+      if (!installWebUpdate(dataDir, _webUpdateDescription, package))
+        return;
 
       //We're done here. Queue up a call to loadWebUpdates
       QTimer::singleShot(0, this, SLOT(loadWebUpdates()));
@@ -969,68 +1001,22 @@ void MainWindow::removeWebUpdates()
     dataDir.remove("web.json");
     dataDir.remove("web.dat");
     clientWrapper()->set_web_package(std::move(std::unordered_map<std::string, std::vector<char>>()));
-    clientWrapper()->get_client()->get_wallet()->lock();
+    clientWrapper()->get_client()->wallet_lock();
     getViewer()->webView()->reload();
   }
 }
 
 void MainWindow::loadWebUpdates()
 {
-  QDir dataDir(QString(clientWrapper()->get_data_dir()));
-  if (!dataDir.exists("web.json")) {
-    wlog("No web update package found.");
-    return;
-  }
-  if (!dataDir.exists("web.dat")) {
-    elog("Found web update package description, but not the package itself.");
-    return;
-  }
-
-  _webUpdateDescription = fc::json::from_file(fc::path(clientWrapper()->get_data_dir().toStdWString()) / "web.json").as<WebUpdateManifest::UpdateDetails>();
-
-  QByteArray updatePackage;
-  QFile packageFile(dataDir.absoluteFilePath("web.dat"));
-  packageFile.open(QIODevice::ReadOnly);
-  updatePackage = packageFile.readAll();
-
-  if (!verifyUpdateSignature(updatePackage)) {
-    elog("Found web update package on disk, but it's signature doesn't check out. Removing it.");
-    dataDir.remove("web.json");
-    dataDir.remove("web.dat");
+  WebPackageFiles webInterfaceMap;
+  if (!loadInstalledWebUpdate(QDir(clientWrapper()->get_data_dir()), _webUpdateDescription, webInterfaceMap))
     return;
-  }
-
-  using std::vector;
-  using std::string;
-  using std::pair;
-
-  vector<char> decompressedStream;
-  try {
-    decompressedStream = fc::lzma_decompress(vector<char>(updatePackage.begin(), updatePackage.end()));
-    updatePackage.clear();
-  } catch (fc::exception e) {
-    elog("Failed to decompress web update package: ${error}", ("error", e.to_detail_string()));
-    return;
-  }
 
-  vector<pair<string, vector<char>>> deserializedPackage;
-  try {
-    fc::datastream<const char*> ds(decompressedStream.data(), decompressedStream.size());
-    fc::raw::unpack(ds, deserializedPackage);
-    decompressedStream.clear();
-  } catch (fc::exception e) {
-    elog("Failed to deserialize web update package: ${error}", ("error", e.to_detail_string()));
-    return;
-  }
-
-  std::unordered_map<string, vector<char>> webInterfaceMap;
-  for (auto& file : deserializedPackage)
-    webInterfaceMap[std::move(file.first)] = std::move(file.second);
   //We load the web updates early in the startup; the client might not be ready yet.
   //That's OK, we don't really need it, but if it's up and running, we want to lock.
-  if (clientWrapper()->get_client() && clientWrapper()->get_client()->get_wallet())
-    clientWrapper()->get_client()->get_wallet()->lock();
+  if (clientWrapper()->get_client())
+    clientWrapper()->get_client()->wallet_lock();
   clientWrapper()->set_web_package(std::move(webInterfaceMap));
-  getViewer()->webView()->reload();
   _patchVersion = _webUpdateDescription.patchVersion;
+  getViewer()->webView()->reload();
 }
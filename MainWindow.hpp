@@ -2,11 +2,14 @@
 
 #include "WebUpdates.hpp"
 #include "ClientWrapper.hpp"
+#include "SyncStatusDialog.hpp"
+#include "WalletBackup.hpp"
 #include "html5viewer/html5viewer.h"
 
 #include <QMainWindow>
 #include <QSettings>
 #include <QMenu>
+#include <QPointer>
 #include <QTimer>
 #include <QUuid>
 
@@ -54,7 +57,6 @@ class MainWindow : public QMainWindow
     void setClientWrapper(ClientWrapper* clientWrapper);
     void navigateTo(const QString& path);
 
-    bool detectCrash();
     QUuid getAppId() const { return app_id; }
 
 public Q_SLOTS:
@@ -84,13 +86,24 @@ public Q_SLOTS:
     void goToBlock(uint32_t blockNumber);
     void goToBlock(QString blockId);
     void goToTransaction(QString transactionId);
+    ///Restores a wallet backup in the background; see WalletBackupImport
     void importWallet();
+    ///Exports the wallet in the background, with a progress dialog that can cancel it
+    void exportWallet();
+    void confirmAndSetApproval(QString delegateName, bool approve);
+    ///Shows sync speed and what limits it, updated live; see ClientWrapper::get_sync_stats
+    void showSyncStatus();
 
 private Q_SLOTS:
     void removeWebUpdates();
+    void blockFound(QString blockId, qint64 blockNumber);
 
 private:
     ClientWrapper* _clientWrapper;
+    QPointer<WalletBackupExport> _walletExport;
+    QPointer<WalletBackupImport> _walletImport;
+    QString _requestedBlockId;
+    QPointer<SyncStatusDialog> _syncStatus;
 
     Html5Viewer* getViewer();
     bool walletIsUnlocked(bool promptToUnlock = true);
@@ -101,6 +114,5 @@ private:
     virtual void closeEvent( QCloseEvent* );
     void initMenu();
     void showNoUpdateAlert(QString info = tr(""));
-    bool verifyUpdateSignature(QByteArray updatePackage);
     void goToRefCode(QStringList components);
 };
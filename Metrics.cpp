@@ -0,0 +1,152 @@
+#include "Metrics.hpp"
+
+#include <QDateTime>
+#include <QJsonDocument>
+#include <QVariantList>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <map>
+#include <mutex>
+
+namespace
+{
+std::mutex                                 g_mutex;
+std::map<std::string, Metrics::Histogram>  g_histograms;
+std::map<std::string, double>              g_gauges;
+std::map<std::string, int64_t>             g_counters;
+std::map<std::string, double>              g_milestones;
+
+//Taken during static initialization, which is as close to process start as we can get portably
+const auto                                 g_process_start = std::chrono::steady_clock::now();
+const qint64                               g_process_start_epoch_ms = QDateTime::currentMSecsSinceEpoch();
+
+int bucket_for(double value)
+{
+  if (value <= 0)
+    return 0;
+  return std::min(63, int(2 * std::log2(value + 1)));
+}
+
+double bucket_upper_bound(int bucket)
+{
+  return std::pow(2.0, (bucket + 1) / 2.0) - 1;
+}
+} // anonymous
+
+void Metrics::Histogram::add(double value)
+{
+  ++_buckets[bucket_for(value)];
+  _min = _count ? std::min(_min, value) : value;
+  _max = _count ? std::max(_max, value) : value;
+  _sum += value;
+  ++_count;
+}
+
+double Metrics::Histogram::percentile(double p) const
+{
+  if (_count == 0)
+    return 0;
+
+  uint64_t rank = std::max<uint64_t>(1, uint64_t(std::ceil(_count * p / 100)));
+  uint64_t seen = 0;
+  for (int i = 0; i < BUCKET_COUNT; ++i)
+  {
+    seen += _buckets[i];
+    if (seen >= rank)
+      return std::min(bucket_upper_bound(i), _max);
+  }
+  return _max;
+}
+
+QVariantMap Metrics::Histogram::toVariant() const
+{
+  QVariantList buckets;
+  for (int i = 0; i < BUCKET_COUNT; ++i)
+    if (_buckets[i])
+      buckets.push_back(QVariantList() << bucket_upper_bound(i) << qulonglong(_buckets[i]));
+
+  QVariantMap result;
+  result["count"] = qulonglong(_count);
+  result["min"] = _min;
+  result["max"] = _max;
+  result["mean"] = mean();
+  result["p50"] = percentile(50);
+  result["p90"] = percentile(90);
+  result["p99"] = percentile(99);
+  result["buckets"] = buckets;
+  return result;
+}
+
+void Metrics::record(const std::string& name, double value)
+{
+  std::lock_guard<std::mutex> lock(g_mutex);
+  g_histograms[name].add(value);
+}
+
+void Metrics::set_gauge(const std::string& name, double value)
+{
+  std::lock_guard<std::mutex> lock(g_mutex);
+  g_gauges[name] = value;
+}
+
+void Metrics::increment(const std::string& name, int64_t by)
+{
+  std::lock_guard<std::mutex> lock(g_mutex);
+  g_counters[name] += by;
+}
+
+void Metrics::mark_milestone(const std::string& name)
+{
+  double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - g_process_start).count();
+  std::lock_guard<std::mutex> lock(g_mutex);
+  g_milestones.insert(std::make_pair(name, elapsed));
+}
+
+QVariantMap Metrics::milestones()
+{
+  std::lock_guard<std::mutex> lock(g_mutex);
+  QVariantMap result;
+  for (const auto& milestone : g_milestones)
+    result[QString::fromStdString(milestone.first)] = milestone.second;
+  result["process_start_epoch_ms"] = g_process_start_epoch_ms;
+  return result;
+}
+
+Metrics::Histogram Metrics::histogram(const std::string& name)
+{
+  std::lock_guard<std::mutex> lock(g_mutex);
+  auto itr = g_histograms.find(name);
+  return itr == g_histograms.end() ? Histogram() : itr->second;
+}
+
+QVariantMap Metrics::snapshot()
+{
+  std::lock_guard<std::mutex> lock(g_mutex);
+
+  QVariantMap histograms;
+  for (const auto& histogram : g_histograms)
+    histograms[QString::fromStdString(histogram.first)] = histogram.second.toVariant();
+  QVariantMap gauges;
+  for (const auto& gauge : g_gauges)
+    gauges[QString::fromStdString(gauge.first)] = gauge.second;
+  QVariantMap counters;
+  for (const auto& counter : g_counters)
+    counters[QString::fromStdString(counter.first)] = qlonglong(counter.second);
+  QVariantMap milestones;
+  for (const auto& milestone : g_milestones)
+    milestones[QString::fromStdString(milestone.first)] = milestone.second;
+
+  QVariantMap result;
+  result["histograms"] = histograms;
+  result["gauges"] = gauges;
+  result["counters"] = counters;
+  result["milestones"] = milestones;
+  return result;
+}
+
+QString Metrics::snapshot_json()
+{
+  return QString::fromUtf8(QJsonDocument::fromVariant(snapshot()).toJson(QJsonDocument::Compact));
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <QVariantMap>
+
+#include <cstdint>
+#include <string>
+
+/** Process-wide registry of counters, gauges and histograms.
+    Safe to update from any thread. Exposed to the web UI as the "metrics" window object
+    and served by the embedded HTTP server as /metrics.json.
+*/
+class Metrics : public QObject
+{
+  Q_OBJECT
+
+  public:
+    /// Log-scale histogram with buckets growing by sqrt(2); good enough for latencies and sizes.
+    class Histogram
+    {
+    public:
+      void add(double value);
+      /// Upper bound of the bucket containing the given percentile (0-100).
+      double percentile(double p) const;
+      QVariantMap toVariant() const;
+
+      uint64_t count() const { return _count; }
+      double   mean() const { return _count ? _sum / _count : 0; }
+      double   max() const { return _max; }
+
+    private:
+      static const int BUCKET_COUNT = 64;
+
+      uint64_t _buckets[BUCKET_COUNT] = {};
+      uint64_t _count = 0;
+      double   _sum = 0;
+      double   _min = 0;
+      double   _max = 0;
+    };
+
+    Metrics(QObject* parent = nullptr) : QObject(parent) {}
+    ~Metrics() {}
+
+    static void record(const std::string& name, double value);
+    static void set_gauge(const std::string& name, double value);
+    static void increment(const std::string& name, int64_t by = 1);
+    /// Records the first time the process reaches the named startup milestone, in ms since
+    /// the process started; later calls with the same name are ignored.
+    static void mark_milestone(const std::string& name);
+
+    /// Copy of the named histogram; empty if nothing was recorded under that name.
+    static Histogram histogram(const std::string& name);
+
+    /// Milestones reached so far, and process_start_epoch_ms (wall clock time they count from).
+    static QVariantMap milestones();
+
+    Q_INVOKABLE static QVariantMap snapshot();
+    Q_INVOKABLE static QString snapshot_json();
+};
@@ -0,0 +1,136 @@
+#include "PeerDialer.hpp"
+
+#include <fc/exception/exception.hpp>
+#include <fc/io/json.hpp>
+#include <fc/log/logger.hpp>
+#include <fc/network/resolve.hpp>
+#include <fc/network/tcp_socket.hpp>
+#include <fc/reflect/variant.hpp>
+#include <fc/thread/thread.hpp>
+
+#include <algorithm>
+#include <tuple>
+
+PeerDialer::PeerDialer(const fc::path& history_file, config c)
+  : _history_file(history_file),
+    _config(c)
+{
+  _config.parallel = std::max<uint32_t>(1, _config.parallel);
+  if (_history_file.string().empty() || !fc::exists(_history_file))
+    return;
+  try
+  {
+    _history = fc::json::from_file(_history_file).as<std::map<std::string, history_entry>>();
+  }
+  catch (const fc::exception& e)
+  {
+    wlog("Ignoring unreadable peer history ${file}: ${e}", ("file", _history_file)("e", e.to_string()));
+  }
+}
+
+std::vector<std::string> PeerDialer::rank(const std::vector<std::string>& candidates) const
+{
+  //Lower sorts first: (group, cost)
+  auto key = [this](const std::string& peer) {
+    auto found = _history.find(peer);
+    if (found == _history.end())
+      return std::make_tuple(1, 0.0);
+    const history_entry& entry = found->second;
+    if (entry.consecutive_failures > 0 || entry.successes == 0)
+      return std::make_tuple(2, double(entry.consecutive_failures));
+    double reliability = double(entry.successes) / (entry.successes + entry.failures);
+    return std::make_tuple(0, entry.latency_ms / reliability);
+  };
+
+  std::vector<std::string> ranked;
+  for (const auto& peer : candidates)
+    if (std::find(ranked.begin(), ranked.end(), peer) == ranked.end())
+      ranked.push_back(peer);
+  std::stable_sort(ranked.begin(), ranked.end(), [&](const std::string& a, const std::string& b) {
+    return key(a) < key(b);
+  });
+  return ranked;
+}
+
+fc::microseconds PeerDialer::probe(const std::string& peer)
+{
+  fc::time_point started = fc::time_point::now();
+  auto colon = peer.rfind(':');
+  FC_ASSERT(colon != std::string::npos, "Peer ${peer} has no port", ("peer", peer));
+  auto endpoints = fc::resolve(peer.substr(0, colon), uint16_t(std::stoul(peer.substr(colon + 1))));
+  FC_ASSERT(!endpoints.empty(), "Unable to resolve ${peer}", ("peer", peer));
+
+  fc::tcp_socket socket;
+  socket.connect_to(endpoints.front());
+  socket.close();
+  return fc::time_point::now() - started;
+}
+
+PeerDialer::result PeerDialer::dial(const std::vector<std::string>& candidates, connect_callback connect)
+{
+  fc::time_point started = fc::time_point::now();
+  const std::vector<std::string> ranked = rank(candidates);
+  result outcome;
+  size_t next = 0;
+
+  //All workers run on this thread, taking turns whenever a probe waits, so they share state without locks
+  auto work = [&] {
+    while (outcome.connected.size() < _config.wanted && next < ranked.size())
+    {
+      const std::string peer = ranked[next++];
+      history_entry& entry = _history[peer];
+      fc::future<fc::microseconds> attempt = fc::async([peer] { return probe(peer); }, "peer probe");
+      try
+      {
+        fc::microseconds latency = attempt.wait(_config.timeout);
+        double ms = latency.count() / 1000.0;
+        entry.latency_ms = entry.successes ? 0.7 * entry.latency_ms + 0.3 * ms : ms;
+        ++entry.successes;
+        entry.consecutive_failures = 0;
+        entry.last_success = fc::time_point::now();
+        if (outcome.connected.size() < _config.wanted)
+        {
+          outcome.connected.push_back(peer);
+          connect(peer);
+        }
+      }
+      catch (const fc::exception& e)
+      {
+        if (!attempt.ready())
+          attempt.cancel();
+        ++entry.failures;
+        ++entry.consecutive_failures;
+        ++outcome.failed;
+        dlog("Seed peer ${peer} did not answer: ${e}", ("peer", peer)("e", e.to_string()));
+      }
+    }
+  };
+
+  std::vector<fc::future<void>> workers;
+  for (uint32_t i = 0; i < std::min<size_t>(_config.parallel, ranked.size()); ++i)
+    workers.push_back(fc::async(work, "peer dialer"));
+  for (auto& worker : workers)
+    worker.wait();
+  outcome.elapsed = fc::time_point::now() - started;
+
+  //The probed peers go first, but a few bad ones mustn't leave the client with nothing else
+  for (const auto& peer : ranked)
+    if (std::find(outcome.connected.begin(), outcome.connected.end(), peer) == outcome.connected.end())
+    {
+      outcome.unconfirmed.push_back(peer);
+      connect(peer);
+    }
+
+  if (!_history_file.string().empty())
+  {
+    try
+    {
+      fc::json::save_to_file(_history, _history_file);
+    }
+    catch (const fc::exception& e)
+    {
+      wlog("Unable to save peer history ${file}: ${e}", ("file", _history_file)("e", e.to_string()));
+    }
+  }
+  return outcome;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <fc/filesystem.hpp>
+#include <fc/reflect/reflect.hpp>
+#include <fc/time.hpp>
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+/** Connects to seed peers at startup. Candidates are ranked by how they did in earlier
+    sessions, then probed several at a time (resolve and open a TCP connection) so dead seeds
+    only cost a timeout in parallel with the live ones. Each peer that answers is handed to
+    the client as soon as it does, until enough of them have. Answering a TCP connect doesn't
+    show a peer speaks the protocol or is on the right chain, so all other candidates are then
+    handed over too, in rank order, for the client to fall back on. What each probe found is
+    kept in a history file for the next start.
+
+    Runs its probes as fc tasks on the calling thread, which must be an fc::thread.
+*/
+class PeerDialer
+{
+public:
+  struct config
+  {
+    /// Probes in flight at once.
+    uint32_t          parallel = 8;
+    /// Stop probing once this many answered; the rest are handed over unprobed.
+    uint32_t          wanted = 4;
+    fc::microseconds  timeout = fc::seconds(5);
+  };
+
+  struct history_entry
+  {
+    /// Moving average of the time to connect.
+    double             latency_ms = 0;
+    uint32_t           successes = 0;
+    uint32_t           failures = 0;
+    uint32_t           consecutive_failures = 0;
+    fc::time_point_sec last_success;
+  };
+
+  struct result
+  {
+    /// Peers that answered, in the order handed to the client.
+    std::vector<std::string> connected;
+    /// The other candidates, handed to the client after those, in rank order.
+    std::vector<std::string> unconfirmed;
+    uint32_t                 failed = 0;
+    /// Time until the wanted number of peers answered, or all were tried.
+    fc::microseconds         elapsed;
+  };
+
+  typedef std::function<void(const std::string& peer)> connect_callback;
+
+  /// The history file is read now and written after dial(); an empty path keeps no history.
+  PeerDialer(const fc::path& history_file, config c);
+
+  /// Peers that answered last time come first, fastest and most reliable first; then peers never
+  /// tried; peers that failed last time come last, those failing longest at the very end.
+  std::vector<std::string> rank(const std::vector<std::string>& candidates) const;
+  /// Probes the ranked candidates and calls connect for each that answers; see the class comment.
+  result dial(const std::vector<std::string>& candidates, connect_callback connect);
+
+  const std::map<std::string, history_entry>& history() const { return _history; }
+
+private:
+  fc::path                             _history_file;
+  config                               _config;
+  std::map<std::string, history_entry> _history;
+
+  /// Resolves the peer ("host:port") and opens a TCP connection to it; returns how long that took.
+  static fc::microseconds probe(const std::string& peer);
+};
+
+FC_REFLECT(PeerDialer::history_entry, (latency_ms)(successes)(failures)(consecutive_failures)(last_success))
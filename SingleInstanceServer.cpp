@@ -0,0 +1,288 @@
+#include "SingleInstanceServer.hpp"
+#include "ClientWrapper.hpp"
+#include "Metrics.hpp"
+
+#include <bts/utilities/git_revision.hpp>
+
+#include <QCoreApplication>
+#include <QJsonDocument>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QPointer>
+#include <QTimer>
+#include <QtEndian>
+
+#include <fc/exception/exception.hpp>
+#include <fc/log/logger.hpp>
+
+/// Reads the frames of one connection as they arrive, answers its commands and closes it
+/// when the peer is done or goes quiet.
+class SingleInstanceServer::Connection : public QObject
+{
+public:
+  Connection(QLocalSocket* socket, SingleInstanceServer* server)
+    : QObject(server),
+      _server(server),
+      _socket(socket)
+  {
+    _socket->setParent(this);
+    _timeout.setSingleShot(true);
+    _timeout.setInterval(ConnectionTimeoutMs);
+
+    connect(_socket, &QLocalSocket::readyRead, this, [this] { read(); });
+    connect(_socket, &QLocalSocket::disconnected, this, [this] {
+      read();
+      finish();
+    });
+    connect(&_timeout, &QTimer::timeout, this, [this] {
+      wlog("Dropping idle connection from another instance");
+      finish();
+    });
+    _timeout.start();
+
+    //Bytes may have arrived with the connection itself
+    if (_socket->bytesAvailable())
+      read();
+  }
+
+private:
+  enum State
+  {
+    ReadingLength,
+    ReadingPayload,
+    ReadingLegacyLine,
+    Finished
+  };
+
+  SingleInstanceServer* _server;
+  QLocalSocket*         _socket;
+  QTimer                _timeout;
+  State                 _state = ReadingLength;
+  QByteArray            _buffer;
+  quint32               _frameSize = 0;
+  int                   _pendingCommands = 0;
+  bool                  _gotMessage = false;
+
+  void read()
+  {
+    if (_state == Finished)
+      return;
+    _buffer += _socket->readAll();
+    if (!_pendingCommands)
+      _timeout.start();
+
+    for (;;)
+    {
+      if (_state == ReadingLength)
+      {
+        if (_buffer.size() < 4)
+          return;
+        _frameSize = qFromBigEndian<quint32>(reinterpret_cast<const uchar*>(_buffer.constData()));
+        if (_frameSize > MaxFrameSize) {
+          _state = ReadingLegacyLine;
+          continue;
+        }
+        _buffer.remove(0, 4);
+        _state = ReadingPayload;
+      }
+      else if (_state == ReadingPayload)
+      {
+        if (quint32(_buffer.size()) < _frameSize)
+          return;
+        QByteArray message = _buffer.left(_frameSize);
+        _buffer.remove(0, _frameSize);
+        _state = ReadingLength;
+        handleFrame(message);
+      }
+      else if (_state == ReadingLegacyLine)
+      {
+        int end = _buffer.indexOf('\n');
+        if (end == -1) {
+          if (quint32(_buffer.size()) > MaxFrameSize)
+            finish();
+          //Old clients don't terminate the line; it ends when they disconnect
+          return;
+        }
+        QByteArray message = _buffer.left(end);
+        _buffer.remove(0, end + 1);
+        openUrl(message.trimmed());
+      }
+      else
+        return;
+    }
+  }
+
+  void handleFrame(const QByteArray& message)
+  {
+    _gotMessage = true;
+    QJsonDocument document = QJsonDocument::fromJson(message);
+    if (!document.isObject() || !document.object().value("command").isString())
+      return openUrl(message);
+
+    QJsonObject request = document.object();
+    QJsonValue id = request.value("id");
+    QPointer<Connection> self(this);
+
+    ++_pendingCommands;
+    _timeout.stop();
+    _server->dispatch(request, [self, id](const QJsonValue& result, const QString& error) {
+      if (!self)
+        return;
+      QJsonObject response{{"id", id}};
+      if (error.isNull())
+        response.insert("result", result);
+      else
+        response.insert("error", error);
+      self->respond(response);
+    });
+  }
+
+  void openUrl(const QByteArray& url)
+  {
+    _gotMessage = true;
+    ilog("Got message from new instance: ${msg}", ("msg", url.data()));
+    _server->dispatch(QJsonObject{{"command", "open_url"}, {"url", QString::fromUtf8(url)}},
+                      [](const QJsonValue&, const QString&) {});
+  }
+
+  void respond(const QJsonObject& response)
+  {
+    if (_state != Finished) {
+      _socket->write(frame(QJsonDocument(response).toJson(QJsonDocument::Compact)));
+      _socket->flush();
+    }
+    if (--_pendingCommands == 0 && _state != Finished)
+      _timeout.start();
+  }
+
+  void finish()
+  {
+    if (_state == Finished)
+      return;
+    if (_state == ReadingLegacyLine && !_buffer.trimmed().isEmpty())
+      openUrl(_buffer.trimmed());
+    //A new instance that has nothing to hand over just connects and leaves
+    if (!_gotMessage)
+      Q_EMIT _server->instanceStarted();
+    _state = Finished;
+    _timeout.stop();
+    _socket->disconnectFromServer();
+    //Responders hold a guarded pointer, but there's no point keeping sockets of long commands around
+    deleteLater();
+  }
+};
+
+SingleInstanceServer::SingleInstanceServer(QObject* parent)
+  : QObject(parent),
+    _server(new QLocalServer(this))
+{
+  connect(_server, &QLocalServer::newConnection, this, &SingleInstanceServer::acceptConnections);
+  setCommandHandler("ping", [](const QJsonObject&, Responder respond) { respond(true, QString()); });
+}
+
+bool SingleInstanceServer::listen(const QString& name)
+{
+  //Commands can shut the wallet down or read its status; keep other local users out
+  _server->setSocketOptions(QLocalServer::UserAccessOption);
+  _error.clear();
+  if (_server->listen(name))
+    return true;
+
+  //Only a listener nobody answers on is defunct; removing a live one would cut its instance off
+  QLocalSocket probe;
+  probe.connectToServer(name);
+  if (probe.waitForConnected(100))
+  {
+    //A ping rather than an empty connection, which a GUI instance would take for a new instance to focus for
+    probe.write(request("ping"));
+    probe.waitForBytesWritten(100);
+    probe.disconnectFromServer();
+    _error = tr("Another instance is already listening on %1").arg(name);
+    return false;
+  }
+
+  wlog("Could not start new instance listener. Attempting to remove defunct listener...");
+  QLocalServer::removeServer(name);
+  return _server->listen(name);
+}
+
+QString SingleInstanceServer::fullServerName() const
+{
+  return _server->fullServerName();
+}
+
+QString SingleInstanceServer::errorString() const
+{
+  return _error.isEmpty() ? _server->errorString() : _error;
+}
+
+void SingleInstanceServer::setCommandHandler(const QString& command, CommandHandler handler)
+{
+  _handlers.insert(command, handler);
+}
+
+void SingleInstanceServer::addClientCommands(ClientWrapper* client)
+{
+  setCommandHandler("get_status", [client](const QJsonObject&, Responder respond) {
+    QJsonObject status{
+      {"application", QCoreApplication::applicationName()},
+      {"version", QString(bts::utilities::git_revision_description)},
+      {"data_dir", client->get_data_dir()},
+      {"initialized", client->is_initialized()}
+    };
+    if (client->get_httpd_endpoint())
+      status.insert("httpd_endpoint", QString::fromStdString(std::string(*client->get_httpd_endpoint())));
+    if (client->is_initialized())
+      status.insert("info", QJsonValue::fromVariant(client->get_info()));
+    respond(status, QString());
+  });
+  setCommandHandler("get_metrics", [](const QJsonObject&, Responder respond) {
+    respond(QJsonObject::fromVariantMap(Metrics::snapshot()), QString());
+  });
+  setCommandHandler("shutdown", [](const QJsonObject&, Responder respond) {
+    wlog("Shutdown requested over the local socket");
+    respond(true, QString());
+    //Let the response go out before the event loop stops
+    QTimer::singleShot(0, QCoreApplication::instance(), &QCoreApplication::quit);
+  });
+}
+
+QByteArray SingleInstanceServer::frame(const QByteArray& payload)
+{
+  QByteArray framed(4, '\0');
+  qToBigEndian<quint32>(payload.size(), reinterpret_cast<uchar*>(framed.data()));
+  return framed + payload;
+}
+
+QByteArray SingleInstanceServer::request(const QString& command, QJsonObject arguments)
+{
+  arguments.insert("command", command);
+  return frame(QJsonDocument(arguments).toJson(QJsonDocument::Compact));
+}
+
+void SingleInstanceServer::acceptConnections()
+{
+  while (QLocalSocket* socket = _server->nextPendingConnection())
+  {
+    new Connection(socket, this);
+  }
+}
+
+void SingleInstanceServer::dispatch(const QJsonObject& request, Responder respond)
+{
+  QString command = request.value("command").toString();
+  auto handler = _handlers.find(command);
+  if (handler == _handlers.end()) {
+    elog("Unknown command from local socket: ${command}", ("command", command.toStdString()));
+    return respond(QJsonValue(), tr("Unknown command: %1").arg(command));
+  }
+
+  try
+  {
+    (*handler)(request, respond);
+  }
+  catch (const fc::exception& e)
+  {
+    respond(QJsonValue(), QString::fromStdString(e.to_string()));
+  }
+}
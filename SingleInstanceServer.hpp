@@ -0,0 +1,72 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QObject>
+#include <QString>
+
+#include <functional>
+
+class ClientWrapper;
+class QLocalServer;
+class QLocalSocket;
+
+/** Local socket server through which other processes talk to the running instance: a newly
+    started instance hands over its custom URL, and scripts use CommandClient to query and
+    drive the wallet. Every connection is a small state machine driven by its socket's
+    signals, so any number of them can be in flight without the GUI event loop ever being
+    re-entered.
+
+    Messages are framed as a 32-bit big-endian length followed by that many bytes. A request
+    is a JSON object {"id": any, "command": name, ...arguments}; it is answered by one frame
+    holding {"id": id, "result": value} or {"id": id, "error": message}. Any other payload is
+    taken for a URL to open, as is the raw, unframed line older versions sent; a length that
+    can't be right is taken for the start of such a line. These get no response.
+*/
+class SingleInstanceServer : public QObject
+{
+  Q_OBJECT
+
+  public:
+    /// Most bytes a frame may carry.
+    static const quint32 MaxFrameSize = 64 * 1024;
+    /// Connections idle for longer than this, with no command in progress, are dropped.
+    static const int ConnectionTimeoutMs = 1000;
+
+    /// Completes a command; pass a null error on success. May be called later, from the event loop.
+    typedef std::function<void(const QJsonValue& result, const QString& error)> Responder;
+    typedef std::function<void(const QJsonObject& request, Responder respond)>  CommandHandler;
+
+    explicit SingleInstanceServer(QObject* parent = nullptr);
+
+    /** Starts listening, first removing a listener left behind by a crashed instance if needed.
+        Fails if another instance still answers on the name, which is then left to it.
+    */
+    bool listen(const QString& name);
+    QString fullServerName() const;
+    QString errorString() const;
+
+    void setCommandHandler(const QString& command, CommandHandler handler);
+    /// Registers get_status, get_metrics and shutdown, which every kind of instance supports.
+    /// ping, answered with true, is always registered.
+    void addClientCommands(ClientWrapper* client);
+
+    static QByteArray frame(const QByteArray& payload);
+    static QByteArray request(const QString& command, QJsonObject arguments = QJsonObject());
+
+  Q_SIGNALS:
+    /// Another instance was started and is leaving without handing anything over.
+    void instanceStarted();
+
+  private:
+    class Connection;
+
+    QLocalServer*                   _server;
+    QHash<QString, CommandHandler>  _handlers;
+    QString                         _error;
+
+    void acceptConnections();
+    void dispatch(const QJsonObject& request, Responder respond);
+};
@@ -0,0 +1,79 @@
+#include "SyncMonitor.hpp"
+
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <ctime>
+#endif
+
+double SyncMonitor::thread_cpu_ms()
+{
+#ifdef _WIN32
+  FILETIME created, exited, kernel, user;
+  if (!GetThreadTimes(GetCurrentThread(), &created, &exited, &kernel, &user))
+    return 0;
+  ULARGE_INTEGER k, u;
+  k.LowPart = kernel.dwLowDateTime; k.HighPart = kernel.dwHighDateTime;
+  u.LowPart = user.dwLowDateTime; u.HighPart = user.dwHighDateTime;
+  //100 ns units
+  return (k.QuadPart + u.QuadPart) / 10000.0;
+#else
+  timespec time;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+  return time.tv_sec * 1000.0 + time.tv_nsec / 1000000.0;
+#endif
+}
+
+SyncMonitor::sample SyncMonitor::take_sample()
+{
+  sample s;
+  fc::time_point now = fc::time_point::now();
+  double cpu_ms = thread_cpu_ms();
+  s.head_block_num = _client->blockchain_head_block_num();
+  s.head_block_age_s = _client->get_info()["blockchain_head_block_age"].as_uint64();
+  std::vector<ClientBackend::peer_traffic> traffic = _client->network_get_peer_traffic();
+
+  double seconds = _last_time == fc::time_point() ? 0 : (now - _last_time).count() / 1000000.0;
+  if (seconds > 0)
+  {
+    s.blocks_per_s = s.head_block_num >= _last_head_block_num ? (s.head_block_num - _last_head_block_num) / seconds : 0;
+    s.thread_busy = std::min(1.0, (cpu_ms - _last_cpu_ms) / (seconds * 1000));
+  }
+
+  std::map<std::string, ClientBackend::peer_traffic> current;
+  for (const auto& peer : traffic)
+  {
+    peer_rate rate;
+    rate.endpoint = peer.endpoint;
+    auto last = _last_traffic.find(peer.endpoint);
+    //Peers that connected since the last sample count from zero
+    if (seconds > 0)
+    {
+      uint64_t received_before = last != _last_traffic.end() ? last->second.bytes_received : 0;
+      uint64_t sent_before = last != _last_traffic.end() ? last->second.bytes_sent : 0;
+      rate.bytes_in_per_s = peer.bytes_received >= received_before ? (peer.bytes_received - received_before) / seconds : 0;
+      rate.bytes_out_per_s = peer.bytes_sent >= sent_before ? (peer.bytes_sent - sent_before) / seconds : 0;
+    }
+    s.bytes_in_per_s += rate.bytes_in_per_s;
+    s.bytes_out_per_s += rate.bytes_out_per_s;
+    s.peers.push_back(rate);
+    current[peer.endpoint] = peer;
+  }
+
+  if (s.head_block_age_s <= synced_age_s)
+    s.bottleneck = "synced";
+  else if (s.peers.empty())
+    s.bottleneck = "no_peers";
+  else if (s.thread_busy >= busy_threshold)
+    s.bottleneck = "cpu";
+  else
+    s.bottleneck = "network";
+
+  _last_time = now;
+  _last_cpu_ms = cpu_ms;
+  _last_head_block_num = s.head_block_num;
+  _last_traffic.swap(current);
+  return s;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "ClientBackend.hpp"
+
+#include <fc/time.hpp>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+/** Samples how fast the client is syncing and what holds it back. Rates are worked out
+    between consecutive samples from the head block number, the bytes exchanged with each
+    peer, and the CPU time of the bitshares thread, which is where blocks are validated and
+    applied. A busy thread means sync is CPU-bound; an idle one while still behind means it is
+    waiting on the network.
+*/
+class SyncMonitor
+{
+public:
+  struct peer_rate
+  {
+    std::string endpoint;
+    double      bytes_in_per_s = 0;
+    double      bytes_out_per_s = 0;
+  };
+
+  struct sample
+  {
+    uint32_t               head_block_num = 0;
+    uint64_t               head_block_age_s = 0;
+    double                 blocks_per_s = 0;
+    double                 bytes_in_per_s = 0;
+    double                 bytes_out_per_s = 0;
+    /// Share of wall time the bitshares thread spent on the CPU, 0 to 1.
+    double                 thread_busy = 0;
+    std::vector<peer_rate> peers;
+    /// "synced", "no_peers", "cpu" or "network".
+    std::string            bottleneck;
+  };
+
+  /// A head block older than this counts as behind.
+  static const uint64_t synced_age_s = 60;
+  /// Above this share the bitshares thread is taken to be the limit.
+  static constexpr double busy_threshold = 0.85;
+
+  explicit SyncMonitor(std::shared_ptr<ClientBackend> client) : _client(client) {}
+
+  /// Must be called on the bitshares thread, whose CPU time it reads. The first sample has no rates.
+  sample take_sample();
+
+  /// CPU time of the calling thread so far.
+  static double thread_cpu_ms();
+
+private:
+  std::shared_ptr<ClientBackend>                            _client;
+  fc::time_point                                            _last_time;
+  double                                                    _last_cpu_ms = 0;
+  uint32_t                                                  _last_head_block_num = 0;
+  std::map<std::string, ClientBackend::peer_traffic>        _last_traffic;
+};
@@ -0,0 +1,129 @@
+#include "SyncStatusDialog.hpp"
+
+#include <QFormLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QSpinBox>
+#include <QTableWidget>
+
+namespace
+{
+QString formatRate(double bytesPerSecond)
+{
+  if (bytesPerSecond >= 1024 * 1024)
+    return QObject::tr("%1 MB/s").arg(bytesPerSecond / (1024 * 1024), 0, 'f', 1);
+  return QObject::tr("%1 KB/s").arg(bytesPerSecond / 1024, 0, 'f', 1);
+}
+} // anonymous
+
+SyncStatusDialog::SyncStatusDialog(QWidget* parent)
+  : QDialog(parent),
+    _headBlock(new QLabel(this)),
+    _blockRate(new QLabel(this)),
+    _traffic(new QLabel(this)),
+    _threadBusy(new QLabel(this)),
+    _bottleneck(new QLabel(this)),
+    _throttle(new QLabel(this)),
+    _cpuBudget(new QSpinBox(this)),
+    _bandwidthBudget(new QSpinBox(this)),
+    _peers(new QTableWidget(0, 3, this))
+{
+  setWindowTitle(tr("Sync Status"));
+  _peers->setHorizontalHeaderLabels(QStringList() << tr("Peer") << tr("Download") << tr("Upload"));
+  _peers->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+  _peers->verticalHeader()->hide();
+  _peers->setEditTriggers(QAbstractItemView::NoEditTriggers);
+
+  _cpuBudget->setRange(5, 100);
+  _cpuBudget->setSuffix(tr("%"));
+  _bandwidthBudget->setRange(0, 1024 * 1024);
+  _bandwidthBudget->setSingleStep(64);
+  _bandwidthBudget->setSuffix(tr(" KB/s"));
+  _bandwidthBudget->setSpecialValueText(tr("No limit"));
+  _cpuBudget->setEnabled(false);
+  _bandwidthBudget->setEnabled(false);
+  connect(_cpuBudget, &QSpinBox::editingFinished, this, &SyncStatusDialog::applyBudget);
+  connect(_bandwidthBudget, &QSpinBox::editingFinished, this, &SyncStatusDialog::applyBudget);
+
+  QFormLayout* layout = new QFormLayout(this);
+  layout->addRow(tr("Head block:"), _headBlock);
+  layout->addRow(tr("Blocks applied:"), _blockRate);
+  layout->addRow(tr("Network:"), _traffic);
+  layout->addRow(tr("Client thread busy:"), _threadBusy);
+  layout->addRow(tr("Limited by:"), _bottleneck);
+  layout->addRow(tr("Throttling:"), _throttle);
+  layout->addRow(tr("Catch-up client thread budget:"), _cpuBudget);
+  layout->addRow(tr("Catch-up download budget:"), _bandwidthBudget);
+  layout->addRow(_peers);
+
+  showStats(QVariantMap());
+}
+
+void SyncStatusDialog::showStats(QVariantMap stats)
+{
+  if (stats.isEmpty())
+  {
+    _headBlock->setText(tr("Waiting for the first sample..."));
+    return;
+  }
+
+  _headBlock->setText(tr("%1 (%2 s old)").arg(stats["head_block_num"].toUInt()).arg(stats["head_block_age_s"].toULongLong()));
+  _blockRate->setText(tr("%1 per second").arg(stats["blocks_per_s"].toDouble(), 0, 'f', 1));
+  _traffic->setText(tr("%1 down, %2 up").arg(formatRate(stats["bytes_in_per_s"].toDouble()))
+                                         .arg(formatRate(stats["bytes_out_per_s"].toDouble())));
+  _threadBusy->setText(tr("%1%").arg(stats["thread_busy"].toDouble() * 100, 0, 'f', 0));
+
+  QString bottleneck = stats["bottleneck"].toString();
+  if (bottleneck == "synced")
+    _bottleneck->setText(tr("Nothing, in sync"));
+  else if (bottleneck == "no_peers")
+    _bottleneck->setText(tr("No connected peers"));
+  else if (bottleneck == "cpu")
+    _bottleneck->setText(tr("CPU, validating blocks"));
+  else
+    _bottleneck->setText(tr("Network, waiting for blocks"));
+
+  QVariantMap throttle = stats["throttle"].toMap();
+  QString state = throttle["state"].toString();
+  const bool catchingUp = throttle["catching_up"].toBool();
+  if (!catchingUp)
+    _throttle->setText(tr("None; only catch-up from block sources is throttled"));
+  else if (state == "yielding")
+    _throttle->setText(tr("Giving way to the wallet %1% of the time").arg(throttle["yielding_share"].toDouble() * 100, 0, 'f', 0));
+  else if (state == "cpu_limited")
+    _throttle->setText(tr("Paused for the CPU budget %1% of the time").arg(throttle["cpu_paused_share"].toDouble() * 100, 0, 'f', 0));
+  else if (state == "bandwidth_limited")
+    _throttle->setText(tr("Downloads held to the budget, %1").arg(formatRate(throttle["catch_up_bytes_per_s"].toDouble())));
+  else if (state == "running")
+    _throttle->setText(tr("Not throttled"));
+  else
+    _throttle->setText(tr("Idle"));
+
+  if (!_budgetShown && !throttle.isEmpty())
+  {
+    _cpuBudget->setValue(qRound(throttle["max_cpu_share"].toDouble() * 100));
+    _bandwidthBudget->setValue(int(throttle["max_bytes_per_s"].toULongLong() / 1024));
+    _budgetShown = true;
+  }
+  //The budgets do nothing to the client's own sync, so they can only be changed while catch-up runs
+  const QString budgetHint = catchingUp ? QString() : tr("Applies only while catching up from block sources (sync/block_sources)");
+  _cpuBudget->setEnabled(_budgetShown && catchingUp);
+  _bandwidthBudget->setEnabled(_budgetShown && catchingUp);
+  _cpuBudget->setToolTip(budgetHint);
+  _bandwidthBudget->setToolTip(budgetHint);
+
+  QVariantList peers = stats["peers"].toList();
+  _peers->setRowCount(peers.size());
+  for (int row = 0; row < peers.size(); ++row)
+  {
+    QVariantMap peer = peers[row].toMap();
+    _peers->setItem(row, 0, new QTableWidgetItem(peer["endpoint"].toString()));
+    _peers->setItem(row, 1, new QTableWidgetItem(formatRate(peer["bytes_in_per_s"].toDouble())));
+    _peers->setItem(row, 2, new QTableWidgetItem(formatRate(peer["bytes_out_per_s"].toDouble())));
+  }
+}
+
+void SyncStatusDialog::applyBudget()
+{
+  Q_EMIT budgetChanged(_cpuBudget->value() / 100.0, qulonglong(_bandwidthBudget->value()) * 1024);
+}
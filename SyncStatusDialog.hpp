@@ -0,0 +1,42 @@
+#pragma once
+
+#include <QDialog>
+#include <QVariantMap>
+
+class QLabel;
+class QSpinBox;
+class QTableWidget;
+
+/** Live view of ClientWrapper::get_sync_stats: overall rates, what limits the sync, how it is
+    throttled, and traffic per peer. The catch-up budgets can be changed from here as well, while
+    catch-up from block sources runs; they don't apply to the client's own sync.
+*/
+class SyncStatusDialog : public QDialog
+{
+  Q_OBJECT
+
+  public:
+    SyncStatusDialog(QWidget* parent = nullptr);
+
+  public Q_SLOTS:
+    void showStats(QVariantMap stats);
+
+  Q_SIGNALS:
+    /// The user changed the budgets; see ClientWrapper::set_sync_budget.
+    void budgetChanged(double maxCpuShare, qulonglong maxBytesPerSecond);
+
+  private:
+    QLabel*       _headBlock;
+    QLabel*       _blockRate;
+    QLabel*       _traffic;
+    QLabel*       _threadBusy;
+    QLabel*       _bottleneck;
+    QLabel*       _throttle;
+    QSpinBox*     _cpuBudget;
+    QSpinBox*     _bandwidthBudget;
+    QTableWidget* _peers;
+    //Budgets are shown once, so a sample doesn't overwrite what the user is typing
+    bool          _budgetShown = false;
+
+    void applyBudget();
+};
@@ -0,0 +1,163 @@
+#include "SyncThrottle.hpp"
+#include "SyncMonitor.hpp"
+
+#include <fc/thread/thread.hpp>
+
+#include <algorithm>
+
+namespace
+{
+const fc::microseconds CPU_WINDOW = fc::seconds(1);
+//Short enough for the GUI not to notice when sync picks up again
+const fc::microseconds YIELD_STEP = fc::milliseconds(5);
+//Pauses shorter than this aren't worth a task switch; the debt is carried over instead
+const double MIN_PAUSE_MS = 2;
+} // anonymous
+
+SyncThrottle::SyncThrottle(config c)
+  : _config(c),
+    _refilled(fc::time_point::now()),
+    _status_start(fc::time_point::now())
+{
+}
+
+SyncThrottle::config SyncThrottle::get_config()
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _config;
+}
+
+void SyncThrottle::set_config(config c)
+{
+  c.max_cpu_share = std::min(1.0, std::max(0.05, c.max_cpu_share));
+  std::lock_guard<std::mutex> lock(_mutex);
+  _config = c;
+  _tokens = std::min<double>(_tokens, double(c.max_bytes_per_s));
+}
+
+void SyncThrottle::interactive_started()
+{
+  if (_interactive_calls++ == 0)
+    _interactive_since = fc::time_point::now().time_since_epoch().count();
+}
+
+void SyncThrottle::interactive_finished()
+{
+  _interactive_until = fc::time_point::now().time_since_epoch().count();
+  --_interactive_calls;
+}
+
+bool SyncThrottle::should_yield(const config& c) const
+{
+  int64_t now = fc::time_point::now().time_since_epoch().count();
+  if (_interactive_calls > 0)
+    return now - _interactive_since < c.max_yield.count();
+  return now - _interactive_until < c.interactive_grace.count();
+}
+
+void SyncThrottle::block_applied()
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  ++_blocks;
+}
+
+void SyncThrottle::pace()
+{
+  config c = get_config();
+
+  fc::time_point started = fc::time_point::now();
+  while (should_yield(c) && fc::time_point::now() - started < c.max_yield)
+    fc::usleep(YIELD_STEP);
+  fc::microseconds yielded = fc::time_point::now() - started;
+
+  fc::microseconds cpu_paused;
+  if (c.max_cpu_share < 1)
+  {
+    fc::time_point now = fc::time_point::now();
+    double cpu_ms = SyncMonitor::thread_cpu_ms();
+    if (_window_start == fc::time_point() || now - _window_start > CPU_WINDOW)
+    {
+      _window_start = now;
+      _window_cpu_ms = cpu_ms;
+    }
+    else
+    {
+      //The wall time the CPU used so far should have taken at this share
+      double used_ms = cpu_ms - _window_cpu_ms;
+      double pause_ms = used_ms / c.max_cpu_share - (now - _window_start).count() / 1000.0;
+      if (pause_ms >= MIN_PAUSE_MS)
+      {
+        fc::usleep(fc::microseconds(int64_t(pause_ms * 1000)));
+        cpu_paused = fc::time_point::now() - now;
+      }
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  _yielded += yielded;
+  _cpu_paused += cpu_paused;
+}
+
+void SyncThrottle::wait_for_bandwidth()
+{
+  fc::time_point started = fc::time_point::now();
+  while (true)
+  {
+    fc::microseconds wait;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (_config.max_bytes_per_s == 0)
+        break;
+      fc::time_point now = fc::time_point::now();
+      _tokens = std::min<double>(double(_config.max_bytes_per_s),
+                                 _tokens + (now - _refilled).count() / 1000000.0 * _config.max_bytes_per_s);
+      _refilled = now;
+      if (_tokens >= 0)
+        break;
+      //Downloads are charged once done, so the bucket runs into debt; wait until it is paid off
+      wait = fc::microseconds(int64_t(-_tokens * 1000000 / _config.max_bytes_per_s) + 1);
+    }
+    fc::usleep(std::min(wait, CPU_WINDOW));
+  }
+
+  fc::microseconds waited = fc::time_point::now() - started;
+  std::lock_guard<std::mutex> lock(_mutex);
+  _bandwidth_paused += waited;
+}
+
+void SyncThrottle::downloaded(uint64_t bytes)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  _bytes += bytes;
+  if (_config.max_bytes_per_s)
+    _tokens -= double(bytes);
+}
+
+SyncThrottle::status SyncThrottle::take_status()
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  fc::time_point now = fc::time_point::now();
+  double seconds = std::max(0.001, (now - _status_start).count() / 1000000.0);
+
+  status s;
+  s.blocks = _blocks;
+  s.bytes_per_s = _bytes / seconds;
+  s.yielding_share = _yielded.count() / 1000000.0 / seconds;
+  s.cpu_paused_share = _cpu_paused.count() / 1000000.0 / seconds;
+  s.bandwidth_paused_share = _bandwidth_paused.count() / 1000000.0 / seconds;
+
+  //Whichever pause took up the most time, if it took up enough to matter
+  double most = std::max(s.yielding_share, std::max(s.cpu_paused_share, s.bandwidth_paused_share));
+  if (most >= 0.05)
+    s.state = most == s.yielding_share ? "yielding" : most == s.cpu_paused_share ? "cpu_limited" : "bandwidth_limited";
+  else
+    s.state = s.blocks || _bytes ? "running" : "idle";
+
+  _status_start = now;
+  _blocks = 0;
+  _bytes = 0;
+  _yielded = fc::microseconds();
+  _cpu_paused = fc::microseconds();
+  _bandwidth_paused = fc::microseconds();
+  return s;
+}
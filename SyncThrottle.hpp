@@ -0,0 +1,112 @@
+#pragma once
+
+#include <fc/time.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+/** Keeps sync within budgets so the GUI stays responsive while the wallet catches up. It holds
+    back sync at two points: pace(), called on the bitshares thread between the blocks catch-up
+    applies, and wait_for_bandwidth(), called before every catch-up download. Both sleep
+    cooperatively, so JSON-RPC calls and other tasks queued on the thread run in the meantime.
+    Neither can be called while a block is being applied, so the client's own peer to peer sync,
+    whose pushes happen inside the bts client, is counted (block_applied()) but not paced.
+
+    - CPU: over windows of about a second, pace() sleeps for as long as it takes to bring the
+      bitshares thread's CPU time back down to max_cpu_share of wall time.
+    - Bandwidth: downloads draw from a token bucket that refills at max_bytes_per_s and holds
+      one second's worth.
+    - Interactive work: while calls from the GUI are in flight, and for interactive_grace after
+      the last one, pace() waits for them. A call running longer than max_yield no longer counts,
+      so a stuck request can't hold sync back for good.
+*/
+class SyncThrottle
+{
+public:
+  struct config
+  {
+    /// Share of the bitshares thread's time, above which sync pauses; 1 for no limit.
+    double           max_cpu_share = 1;
+    /// Download rate for catching up; 0 for no limit.
+    uint64_t         max_bytes_per_s = 0;
+    fc::microseconds interactive_grace = fc::milliseconds(200);
+    fc::microseconds max_yield = fc::seconds(2);
+  };
+
+  /// What held sync back between two calls of take_status().
+  struct status
+  {
+    /// "idle" (no blocks applied), "running", "yielding", "cpu_limited" or "bandwidth_limited".
+    std::string state;
+    /// Shares of wall time spent paused, 0 to 1.
+    double      yielding_share = 0;
+    double      cpu_paused_share = 0;
+    /// Summed over the downloading threads, so this can exceed 1.
+    double      bandwidth_paused_share = 0;
+    uint32_t    blocks = 0;
+    double      bytes_per_s = 0;
+  };
+
+  /// RAII marker for interactive work; sync gives way while one exists.
+  class interactive_scope
+  {
+  public:
+    explicit interactive_scope(SyncThrottle& throttle) : _throttle(throttle) { _throttle.interactive_started(); }
+    ~interactive_scope() { _throttle.interactive_finished(); }
+
+  private:
+    SyncThrottle& _throttle;
+  };
+
+  explicit SyncThrottle(config c = config());
+
+  config get_config();
+  /// Takes effect from the next block or download.
+  void set_config(config c);
+
+  /// From any thread.
+  void interactive_started();
+  void interactive_finished();
+
+  /// Counts a block applied, by catch-up or the client's own sync, for take_status(). From any thread.
+  void block_applied();
+  /// Waits as the budgets require before the next block. On the bitshares thread only, and never
+  /// from within push_block (a chain observer), which would hold the chain mid-update meanwhile.
+  void pace();
+  /// Waits until the bandwidth budget allows another download. From any fc thread.
+  void wait_for_bandwidth();
+  /// Charges a finished download to the bandwidth budget.
+  void downloaded(uint64_t bytes);
+
+  /// State since the previous call.
+  status take_status();
+
+private:
+  std::mutex                 _mutex;
+  config                     _config;
+
+  std::atomic<int>           _interactive_calls{0};
+  //Microseconds since the epoch, of when the calls in flight started and of when the last one finished
+  std::atomic<int64_t>       _interactive_since{0};
+  std::atomic<int64_t>       _interactive_until{0};
+
+  //CPU window of pace(); bitshares thread only
+  fc::time_point             _window_start;
+  double                     _window_cpu_ms = 0;
+
+  //Token bucket, under _mutex
+  double                     _tokens = 0;
+  fc::time_point             _refilled;
+
+  //Status since take_status(), under _mutex
+  fc::time_point             _status_start;
+  fc::microseconds           _yielded;
+  fc::microseconds           _cpu_paused;
+  fc::microseconds           _bandwidth_paused;
+  uint32_t                   _blocks = 0;
+  uint64_t                   _bytes = 0;
+
+  bool should_yield(const config& c) const;
+};
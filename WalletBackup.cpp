@@ -0,0 +1,337 @@
+#include "WalletBackup.hpp"
+#include "ClientWrapper.hpp"
+
+#include <fc/log/logger.hpp>
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QTemporaryFile>
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+const qint64 CHUNK_SIZE = 256 * 1024;
+//Share of the progress bar for the client writing its backup, which reports no progress of its own
+const int CREATE_PERCENT = 20;
+} // anonymous
+
+WalletBackupExport::WalletBackupExport(ClientWrapper* client, const QString& destination, bool compress, QObject* parent)
+  : QObject(parent),
+    _client(client),
+    _destination(destination),
+    _compress(compress),
+    _thread("wallet export")
+{
+  //Must be done before ClientWrapper shuts the client down
+  connect(qApp, &QCoreApplication::aboutToQuit, this, [this] {
+    cancel();
+    wait();
+  });
+}
+
+WalletBackupExport::~WalletBackupExport()
+{
+  cancel();
+  wait();
+}
+
+void WalletBackupExport::start()
+{
+  _done = _thread.async([this] { run(); });
+}
+
+void WalletBackupExport::cancel()
+{
+  _cancelled = true;
+}
+
+void WalletBackupExport::wait()
+{
+  if (_done.valid() && !_done.ready())
+    _done.wait();
+}
+
+void WalletBackupExport::run()
+{
+  QFileInfo destination(_destination);
+  QString scratch = destination.absoluteDir().absoluteFilePath("." + destination.fileName() + ".export");
+  auto finish = [&](const QString& error) {
+    QFile::remove(scratch);
+    if (_cancelled)
+      ilog("Wallet export to ${path} cancelled", ("path", _destination.toStdString()));
+    else
+      elog("Wallet export to ${path} failed: ${e}", ("path", _destination.toStdString())("e", error.toStdString()));
+    Q_EMIT finished(false, _cancelled ? QString() : error);
+  };
+
+  Q_EMIT progress(0);
+  try
+  {
+    _client->bitshares_thread().async([this, scratch] {
+      _client->get_client()->wallet_backup_create(fc::path(scratch.toStdWString()));
+    }).wait();
+  }
+  catch (const fc::exception& e)
+  {
+    return finish(QString::fromStdString(e.to_string()));
+  }
+  if (_cancelled)
+    return finish(QString());
+  Q_EMIT progress(CREATE_PERCENT);
+
+  QFile input(scratch);
+  QSaveFile output(_destination);
+  if (!input.open(QIODevice::ReadOnly))
+    return finish(input.errorString());
+  if (!output.open(QIODevice::WriteOnly))
+    return finish(output.errorString());
+
+  z_stream zip = {};
+  //31 selects a gzip header instead of a raw zlib stream
+  if (_compress && deflateInit2(&zip, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 31, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    return finish(tr("Unable to start compression"));
+
+  std::vector<char> in(CHUNK_SIZE);
+  std::vector<char> out(CHUNK_SIZE);
+  const qint64 total = std::max<qint64>(1, input.size());
+  qint64 done = 0;
+  QString error;
+  while (!_cancelled && error.isEmpty())
+  {
+    qint64 count = input.read(in.data(), CHUNK_SIZE);
+    if (count < 0)
+    {
+      error = input.errorString();
+      break;
+    }
+    bool last = count == 0 || input.atEnd();
+
+    if (!_compress)
+    {
+      if (output.write(in.data(), count) != count)
+        error = output.errorString();
+    }
+    else
+    {
+      zip.next_in = reinterpret_cast<Bytef*>(in.data());
+      zip.avail_in = uInt(count);
+      do
+      {
+        zip.next_out = reinterpret_cast<Bytef*>(out.data());
+        zip.avail_out = uInt(out.size());
+        deflate(&zip, last ? Z_FINISH : Z_NO_FLUSH);
+        qint64 produced = qint64(out.size()) - zip.avail_out;
+        if (output.write(out.data(), produced) != produced)
+          error = output.errorString();
+      } while (error.isEmpty() && zip.avail_out == 0);
+    }
+
+    done += count;
+    Q_EMIT progress(CREATE_PERCENT + int((100 - CREATE_PERCENT) * done / total));
+    if (last)
+      break;
+  }
+  if (_compress)
+    deflateEnd(&zip);
+  input.close();
+
+  if (_cancelled || !error.isEmpty())
+  {
+    output.cancelWriting();
+    return finish(error);
+  }
+  //Renames the complete backup into place
+  if (!output.commit())
+    return finish(output.errorString());
+
+  QFile::remove(scratch);
+  ilog("Exported wallet to ${path}", ("path", _destination.toStdString()));
+  Q_EMIT finished(true, QString());
+}
+
+WalletBackupImport::WalletBackupImport(ClientWrapper* client, const QString& backupPath, const QString& walletName,
+                                       const QString& passphrase, QObject* parent)
+  : QObject(parent),
+    _client(client),
+    _backupPath(backupPath),
+    _walletName(walletName),
+    _passphrase(passphrase),
+    _thread("wallet import")
+{
+  //Half a restore would leave the wallet renamed aside, so a restore under way is let finish before
+  //the client shuts down; anything else stops early
+  connect(qApp, &QCoreApplication::aboutToQuit, this, [this] {
+    cancel();
+    wait();
+  });
+}
+
+WalletBackupImport::~WalletBackupImport()
+{
+  cancel();
+  wait();
+}
+
+void WalletBackupImport::start()
+{
+  _done = _thread.async([this] { run(); });
+}
+
+void WalletBackupImport::cancel()
+{
+  _cancelled = true;
+}
+
+void WalletBackupImport::wait()
+{
+  if (_done.valid() && !_done.ready())
+    _done.wait();
+}
+
+void WalletBackupImport::fail(Phase phase, const QString& error)
+{
+  if (_cancelled)
+    ilog("Wallet import from ${path} cancelled", ("path", _backupPath.toStdString()));
+  else
+    elog("Wallet import from ${path} failed: ${e}", ("path", _backupPath.toStdString())("e", error.toStdString()));
+  Q_EMIT failed(phase, _cancelled ? QString() : error);
+}
+
+QString WalletBackupImport::uncompressedBackup(QString& error)
+{
+  QFile backup(_backupPath);
+  if (!backup.open(QIODevice::ReadOnly)) {
+    error = backup.errorString();
+    return QString();
+  }
+  //Gzip magic
+  if (!backup.peek(2).startsWith("\x1f\x8b"))
+    return _backupPath;
+
+  _uncompressed.reset(new QTemporaryFile);
+  QTemporaryFile* uncompressed = _uncompressed.get();
+  if (!uncompressed->open()) {
+    error = uncompressed->errorString();
+    return QString();
+  }
+
+  z_stream zip = {};
+  //47 accepts zlib and gzip headers alike
+  if (inflateInit2(&zip, 47) != Z_OK) {
+    error = tr("Unable to start decompression");
+    return QString();
+  }
+  std::vector<char> in(CHUNK_SIZE);
+  std::vector<char> out(CHUNK_SIZE);
+  int result = Z_OK;
+  while (result != Z_STREAM_END && error.isEmpty() && !_cancelled)
+  {
+    qint64 count = backup.read(in.data(), CHUNK_SIZE);
+    if (count <= 0) {
+      error = count < 0 ? backup.errorString() : tr("The backup file is truncated");
+      break;
+    }
+    zip.next_in = reinterpret_cast<Bytef*>(in.data());
+    zip.avail_in = uInt(count);
+    do
+    {
+      zip.next_out = reinterpret_cast<Bytef*>(out.data());
+      zip.avail_out = uInt(out.size());
+      result = inflate(&zip, Z_NO_FLUSH);
+      if (result != Z_OK && result != Z_STREAM_END) {
+        error = tr("The backup file is corrupt");
+        break;
+      }
+      qint64 produced = qint64(out.size()) - zip.avail_out;
+      if (uncompressed->write(out.data(), produced) != produced)
+        error = uncompressed->errorString();
+    } while (error.isEmpty() && zip.avail_out == 0);
+  }
+  inflateEnd(&zip);
+  uncompressed->flush();
+  return error.isEmpty() ? uncompressed->fileName() : QString();
+}
+
+bool WalletBackupImport::restore(QDir walletDirectory, const QString& jsonPath, QString& error)
+{
+  QString backupName = _walletName + "-backup-" + QDateTime::currentDateTime().toString(Qt::ISODate).replace(':', "");
+  bool renamed = false;
+  try
+  {
+    auto client = _client->get_client();
+    client->wallet_close();
+    if (walletDirectory.exists(_walletName))
+      renamed = walletDirectory.rename(_walletName, backupName);
+    client->wallet_backup_restore(fc::path(jsonPath.toStdWString()), _walletName.toStdString(), _passphrase.toStdString());
+    return true;
+  }
+  catch (const fc::exception& e)
+  {
+    error = QString::fromStdString(e.to_string());
+  }
+
+  //Put the original wallet back the way it was
+  if (walletDirectory.exists(_walletName))
+    QDir(walletDirectory.absoluteFilePath(_walletName)).removeRecursively();
+  if (renamed)
+    walletDirectory.rename(backupName, _walletName);
+  try
+  {
+    _client->get_client()->wallet_open(_walletName.toStdString());
+  }
+  catch (const fc::exception& e)
+  {
+    wlog("Unable to reopen the original wallet: ${e}", ("e", e.to_detail_string()));
+  }
+  return false;
+}
+
+void WalletBackupImport::run()
+{
+  Q_EMIT phaseChanged(Parsing);
+  QString error;
+  QString jsonPath = uncompressedBackup(error);
+  if (jsonPath.isEmpty())
+    return fail(Parsing, error);
+  if (_cancelled)
+    return fail(Parsing, QString());
+  //Only a quick look: the client parses the whole backup as it restores it, and the original
+  //wallet is put back if that fails
+  QFile json(jsonPath);
+  if (!json.open(QIODevice::ReadOnly))
+    return fail(Parsing, json.errorString());
+  if (!json.read(4096).trimmed().startsWith('{'))
+    return fail(Parsing, tr("The file is not a wallet backup"));
+
+  Q_EMIT phaseChanged(Restoring);
+  fc::thread& bitshares = _client->bitshares_thread();
+  QDir walletDirectory = bitshares.async([this] {
+    return QString::fromStdWString(_client->get_client()->wallet_data_directory().generic_wstring());
+  }).wait();
+  bool restored = bitshares.async([&] { return restore(walletDirectory, jsonPath, error); }).wait();
+  //Either wallet may be open now
+  _client->reload_account_roster();
+  if (!restored)
+    return fail(Restoring, error);
+
+  Q_EMIT phaseChanged(Rescanning);
+  try
+  {
+    _client->rescan_wallet(0, [this](float percent) { Q_EMIT rescanProgress(int(percent)); }, &_cancelled);
+  }
+  catch (const fc::exception& e)
+  {
+    return fail(Rescanning, QString::fromStdString(e.to_string()));
+  }
+
+  ilog("Imported wallet from ${path}", ("path", _backupPath.toStdString()));
+  Q_EMIT succeeded();
+}
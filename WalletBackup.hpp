@@ -0,0 +1,105 @@
+#pragma once
+
+#include <fc/thread/future.hpp>
+#include <fc/thread/thread.hpp>
+
+#include <QDir>
+#include <QObject>
+#include <QString>
+
+#include <atomic>
+#include <memory>
+
+class ClientWrapper;
+class QTemporaryFile;
+
+/** Exports the wallet to a backup file in the background. The client writes its JSON backup
+    on the bitshares thread, to a scratch file next to the destination; that is then streamed
+    in chunks, gzip compressed if asked to, into a QSaveFile, so the destination only ever
+    holds a complete backup (an earlier one stays in place until the new one is done).
+    Cancelling takes effect once the client has written its backup, which can't be interrupted,
+    and between chunks after that. Quitting the application cancels the export and waits for it.
+*/
+class WalletBackupExport : public QObject
+{
+  Q_OBJECT
+
+  public:
+    WalletBackupExport(ClientWrapper* client, const QString& destination, bool compress, QObject* parent = nullptr);
+    virtual ~WalletBackupExport();
+
+    void start();
+    void cancel();
+    /// Blocks until the export has finished, failed or noticed it was cancelled.
+    void wait();
+
+    QString destination() const { return _destination; }
+
+  Q_SIGNALS:
+    /// Percentage done, 0 to 100.
+    void progress(int percent);
+    /// The error is empty if the export succeeded or was cancelled.
+    void finished(bool success, QString error);
+
+  private:
+    ClientWrapper*    _client;
+    QString           _destination;
+    bool              _compress;
+    std::atomic<bool> _cancelled{false};
+    fc::thread        _thread;
+    fc::future<void>  _done;
+
+    void run();
+};
+
+/** Restores a wallet backup (plain or gzip compressed JSON) in the background, in three phases:
+    the backup is uncompressed and checked to be JSON first, so a wrong file fails before the
+    current wallet is touched; then the current wallet is closed and renamed aside and the backup
+    restored in its place; last, the chain is rescanned for the restored wallet's transactions, on
+    several threads (see ClientWrapper::rescan_wallet). If the restore fails, the renamed wallet
+    is put back and reopened. The wallet can be used again during the rescan. Quitting the
+    application cancels the import, waiting only for a restore under way to finish.
+*/
+class WalletBackupImport : public QObject
+{
+  Q_OBJECT
+
+  public:
+    enum Phase { Parsing, Restoring, Rescanning };
+
+    WalletBackupImport(ClientWrapper* client, const QString& backupPath, const QString& walletName,
+                       const QString& passphrase, QObject* parent = nullptr);
+    virtual ~WalletBackupImport();
+
+    void start();
+    /// Stops the import before it restores anything, or the rescan between batches of blocks; a restore under way is finished.
+    void cancel();
+    /// Blocks until the import has finished, failed or noticed it was cancelled.
+    void wait();
+
+  Q_SIGNALS:
+    /// The phase now running, as a Phase.
+    void phaseChanged(int phase);
+    /// Percentage of the chain rescanned, 0 to 100.
+    void rescanProgress(int percent);
+    void succeeded();
+    /// A failure while Restoring means the original wallet was put back; during Rescanning, the backup was restored.
+    /// The error is null if the import was cancelled.
+    void failed(int phase, QString error);
+
+  private:
+    ClientWrapper*    _client;
+    QString           _backupPath;
+    QString           _walletName;
+    QString           _passphrase;
+    std::atomic<bool> _cancelled{false};
+    fc::thread        _thread;
+    fc::future<void>  _done;
+    std::unique_ptr<QTemporaryFile> _uncompressed;
+
+    void run();
+    void fail(Phase phase, const QString& error);
+    /// Returns the path of the uncompressed backup, which is the backup itself unless it is gzip compressed.
+    QString uncompressedBackup(QString& error);
+    bool restore(QDir walletDirectory, const QString& jsonPath, QString& error);
+};
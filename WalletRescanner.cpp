@@ -0,0 +1,219 @@
+#include "WalletRescanner.hpp"
+
+#include <bts/blockchain/account_operations.hpp>
+#include <bts/blockchain/balance_operations.hpp>
+#include <bts/blockchain/market_operations.hpp>
+#include <bts/blockchain/operations.hpp>
+
+#include <fc/thread/thread.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <string>
+
+WalletRescanner::WalletRescanner(std::shared_ptr<ClientBackend> client, fc::thread& chain_thread,
+                                 std::unordered_set<bts::blockchain::address> addresses,
+                                 std::unordered_set<bts::blockchain::account_id_type> account_ids, uint32_t thread_count)
+  : _client(client),
+    _chain_thread(chain_thread),
+    _addresses(std::move(addresses)),
+    _account_ids(std::move(account_ids)),
+    _filter(_addresses),
+    _thread_count(std::max<uint32_t>(1, thread_count))
+{
+}
+
+bool WalletRescanner::is_ours(const bts::blockchain::address& address) const
+{
+  return _filter.may_contain(address) && _addresses.count(address) != 0;
+}
+
+WalletRescanner::match WalletRescanner::check(const bts::blockchain::signed_transaction& transaction) const
+{
+  using namespace bts::blockchain;
+  match result;
+
+  for (const operation& op : transaction.operations)
+  {
+    switch (op.type.value)
+    {
+    case withdraw_op_type:
+      result.spent.push_back(op.as<withdraw_operation>().balance_id);
+      break;
+    case deposit_op_type:
+    {
+      auto deposit = op.as<deposit_operation>();
+      fc::optional<address> owner = deposit.condition.owner();
+      if (owner && is_ours(*owner))
+      {
+        result.ours = true;
+        result.received.push_back(deposit.condition.get_address());
+      }
+      break;
+    }
+    case withdraw_pay_op_type:
+      result.ours |= _account_ids.count(op.as<withdraw_pay_operation>().account_id) != 0;
+      break;
+    case register_account_op_type:
+    {
+      auto registration = op.as<register_account_operation>();
+      result.ours |= is_ours(address(registration.owner_key)) || is_ours(address(registration.active_key));
+      break;
+    }
+    case update_account_op_type:
+    {
+      auto update = op.as<update_account_operation>();
+      result.ours |= update.active_key && is_ours(address(*update.active_key));
+      break;
+    }
+    case bid_op_type:
+      result.ours |= is_ours(op.as<bid_operation>().bid_index.owner);
+      break;
+    case ask_op_type:
+      result.ours |= is_ours(op.as<ask_operation>().ask_index.owner);
+      break;
+    case short_op_type:
+      result.ours |= is_ours(op.as<short_operation>().short_index.owner);
+      break;
+    case cover_op_type:
+      result.ours |= is_ours(op.as<cover_operation>().cover_index.owner);
+      break;
+    case add_collateral_op_type:
+      result.ours |= is_ours(op.as<add_collateral_operation>().cover_index.owner);
+      break;
+    default:
+      break;
+    }
+  }
+  return result;
+}
+
+std::vector<bts::blockchain::transaction_id_type> WalletRescanner::scan(uint32_t first_block, uint32_t last_block,
+                                                                        progress_callback progress,
+                                                                        const std::atomic<bool>* cancelled)
+{
+  std::vector<bts::blockchain::transaction_id_type> found;
+  if (first_block > last_block || _addresses.empty())
+    return found;
+
+  const uint64_t block_count = uint64_t(last_block) - first_block + 1;
+  const uint32_t chunk_count = uint32_t((block_count + chunk_size - 1) / chunk_size);
+  //A transaction that may be ours, kept in chain order until the wallet's balances are all known
+  struct candidate
+  {
+    bts::blockchain::transaction_id_type          id;
+    bool                                          ours;
+    std::vector<bts::blockchain::balance_id_type> spent;
+  };
+  struct chunk_result
+  {
+    std::vector<candidate>                               candidates;
+    std::unordered_set<bts::blockchain::balance_id_type> wallet_balances;
+  };
+  std::vector<chunk_result> chunks(chunk_count);
+  std::atomic<uint32_t> next_chunk{0};
+  std::atomic<uint64_t> blocks_done{0};
+  std::atomic<bool> failed{false};
+  std::mutex progress_mutex;
+
+  auto work = [&] {
+    try
+    {
+      for (uint32_t chunk = next_chunk++; chunk < chunk_count && !failed; chunk = next_chunk++)
+      {
+        uint32_t begin = first_block + chunk * chunk_size;
+        uint32_t end = uint32_t(std::min<uint64_t>(uint64_t(begin) + chunk_size - 1, last_block));
+        for (uint32_t batch = begin; batch <= end && !failed; batch += read_batch)
+        {
+          if (cancelled && *cancelled)
+            FC_THROW_EXCEPTION(fc::canceled_exception, "Rescan cancelled");
+          uint32_t batch_end = uint32_t(std::min<uint64_t>(uint64_t(batch) + read_batch - 1, end));
+          auto blocks = _chain_thread.async([&] {
+            std::vector<std::vector<bts::blockchain::signed_transaction>> read;
+            for (uint32_t block_num = batch; block_num <= batch_end; ++block_num)
+              read.push_back(_client->blockchain_get_block_transactions(block_num));
+            return read;
+          }).wait();
+
+          chunk_result& result = chunks[chunk];
+          std::vector<bts::blockchain::balance_id_type> unknown_spends;
+          for (const auto& block : blocks)
+            for (const auto& transaction : block)
+            {
+              match m = check(transaction);
+              result.wallet_balances.insert(m.received.begin(), m.received.end());
+              if (m.ours)
+                result.candidates.push_back({transaction.id(), true, {}});
+              else if (!m.spent.empty())
+              {
+                unknown_spends.insert(unknown_spends.end(), m.spent.begin(), m.spent.end());
+                result.candidates.push_back({transaction.id(), false, std::move(m.spent)});
+              }
+            }
+          if (unknown_spends.empty())
+            continue;
+
+          auto owners = _chain_thread.async([&] {
+            return _client->blockchain_get_balance_owners(unknown_spends);
+          }).wait();
+          for (size_t i = 0; i < owners.size(); ++i)
+            if (owners[i] && is_ours(*owners[i]))
+              result.wallet_balances.insert(unknown_spends[i]);
+        }
+
+        uint64_t done = blocks_done += end - begin + 1;
+        if (progress)
+        {
+          std::lock_guard<std::mutex> lock(progress_mutex);
+          progress(100.0f * done / block_count);
+        }
+      }
+    }
+    catch (...)
+    {
+      //Let the other workers stop early; the exception reaches the caller through the future
+      failed = true;
+      throw;
+    }
+  };
+
+  //No more workers than chunks, so a short rescan doesn't pay for idle threads
+  const uint32_t worker_count = std::min(_thread_count, chunk_count);
+  std::vector<std::unique_ptr<fc::thread>> workers;
+  std::vector<fc::future<void>> done;
+  for (uint32_t i = 0; i < worker_count; ++i)
+  {
+    workers.emplace_back(new fc::thread("rescan " + std::to_string(i)));
+    done.push_back(workers.back()->async(work));
+  }
+  //Wait for all of them before rethrowing, as they work on this frame's state
+  fc::exception_ptr error;
+  for (auto& worker : done)
+  {
+    try
+    {
+      worker.wait();
+    }
+    catch (const fc::exception& e)
+    {
+      if (!error)
+        error = e.dynamic_copy_exception();
+    }
+  }
+  for (auto& worker : workers)
+    worker->quit();
+  if (error)
+    error->dynamic_rethrow_exception();
+
+  //A withdraw may spend a balance received in a later chunk, so spends are only settled now
+  std::unordered_set<bts::blockchain::balance_id_type> wallet_balances;
+  for (auto& result : chunks)
+    wallet_balances.insert(result.wallet_balances.begin(), result.wallet_balances.end());
+  for (auto& result : chunks)
+    for (auto& candidate : result.candidates)
+      if (candidate.ours || std::any_of(candidate.spent.begin(), candidate.spent.end(),
+                                        [&](const bts::blockchain::balance_id_type& id) { return wallet_balances.count(id) != 0; }))
+        found.push_back(candidate.id);
+  return found;
+}
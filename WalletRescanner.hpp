@@ -0,0 +1,76 @@
+#pragma once
+
+#include "AddressFilter.hpp"
+#include "ClientBackend.hpp"
+
+#include <bts/blockchain/address.hpp>
+#include <bts/blockchain/transaction.hpp>
+
+#include <fc/thread/thread.hpp>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+/** Finds the transactions touching a set of wallet addresses in a range of blocks, matching them
+    on several threads. The range is cut into chunks which idle workers take in turn, so a slow
+    stretch of chain doesn't hold up the rest; matches are put back in chain order once all
+    workers are done. Outputs are checked against an AddressFilter before the exact lookup.
+    The chain database is only safe to use from the thread that owns it, so workers have their
+    blocks read there, read_batch blocks per call, and the client's other work can run between
+    the batches. Only matching runs in parallel: a rescan goes no faster than that one thread
+    can read blocks, however many workers there are. Only reads the chain, so the client keeps
+    running meanwhile.
+
+    A withdraw names only the balance it spends, so its owner is looked up on the chain thread
+    too. Balances the chain no longer knows are matched against those the scan saw the wallet
+    receive, once every chunk is done. Adding what was found to the wallet is up to the caller
+    (see ClientWrapper::rescan_wallet), which builds a new scanner, and with it a new filter,
+    from the wallet's current keys for every rescan.
+*/
+class WalletRescanner
+{
+public:
+  /// Percentage of blocks scanned so far; called from the worker threads.
+  typedef std::function<void(float)> progress_callback;
+
+  /// What a transaction does for the wallet, as far as the transaction alone tells.
+  struct match
+  {
+    /// It pays, registers, updates or trades for one of the wallet's addresses or accounts.
+    bool ours = false;
+    /// Balances it withdraws from; it is also ours if one of them is the wallet's.
+    std::vector<bts::blockchain::balance_id_type> spent;
+    /// Balances it deposits to one of the addresses, which later withdraws may spend.
+    std::vector<bts::blockchain::balance_id_type> received;
+  };
+
+  static const uint32_t chunk_size = 1000;
+  /// Blocks read per trip to the chain thread.
+  static const uint32_t read_batch = 100;
+
+  /// chain_thread is the thread the client's chain database belongs to.
+  WalletRescanner(std::shared_ptr<ClientBackend> client, fc::thread& chain_thread,
+                  std::unordered_set<bts::blockchain::address> addresses,
+                  std::unordered_set<bts::blockchain::account_id_type> account_ids, uint32_t thread_count);
+
+  /// Ids of the matching transactions in blocks first_block to last_block inclusive, in chain order.
+  /// Throws fc::canceled_exception once the workers see *cancelled set, which they check between batches.
+  std::vector<bts::blockchain::transaction_id_type> scan(uint32_t first_block, uint32_t last_block,
+                                                         progress_callback progress = progress_callback(),
+                                                         const std::atomic<bool>* cancelled = nullptr);
+
+  match check(const bts::blockchain::signed_transaction& transaction) const;
+
+private:
+  std::shared_ptr<ClientBackend>                       _client;
+  fc::thread&                                          _chain_thread;
+  std::unordered_set<bts::blockchain::address>         _addresses;
+  std::unordered_set<bts::blockchain::account_id_type> _account_ids;
+  AddressFilter                                        _filter;
+  uint32_t                                             _thread_count;
+
+  bool is_ours(const bts::blockchain::address& address) const;
+};
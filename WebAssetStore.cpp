@@ -0,0 +1,50 @@
+#include "WebAssetStore.hpp"
+
+#include <QResource>
+
+void WebAssetStore::set_package(Package&& package)
+{
+  auto installed = package.empty() ? std::shared_ptr<const Package>() : std::make_shared<const Package>(std::move(package));
+  std::lock_guard<std::mutex> lock(_mutex);
+  _package = installed;
+}
+
+bool WebAssetStore::has_package() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return bool(_package);
+}
+
+WebAssetStore::Asset WebAssetStore::find(const fc::path& filename) const
+{
+  Asset asset;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    asset._package = _package;
+  }
+
+  //Check the update package first, then fall back to QRC.
+  if (asset._package) {
+    auto file = asset._package->find(filename.to_native_ansi_path());
+    if (file != asset._package->end()) {
+      asset._found = true;
+      asset._data = file->second.data();
+      asset._size = file->second.size();
+    }
+    return asset;
+  }
+
+  //No update package. Use QRC.
+  QResource file(("/htdocs/htdocs/" + filename.generic_string()).c_str());
+  if (!file.data())
+    return asset;
+
+  asset._found = true;
+  if (file.isCompressed())
+    asset._uncompressed = qUncompress(file.data(), file.size());
+  else {
+    asset._data = (const char*)file.data();
+    asset._size = file.size();
+  }
+  return asset;
+}
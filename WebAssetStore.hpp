@@ -0,0 +1,48 @@
+#pragma once
+
+#include <fc/filesystem.hpp>
+
+#include <QByteArray>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/** The web GUI files: an installed web update package if there is one, otherwise the
+    htdocs compiled into the QRC. Lookups may come from any thread.
+*/
+class WebAssetStore
+{
+  public:
+    typedef std::unordered_map<std::string, std::vector<char>> Package;
+
+    /// Bytes of one file. Holds on to the package it points into, so it stays valid
+    /// even if another package gets installed while it is in use.
+    class Asset
+    {
+    public:
+      bool        found() const { return _found; }
+      const char* data() const { return _uncompressed.isNull() ? _data : _uncompressed.constData(); }
+      uint64_t    size() const { return _uncompressed.isNull() ? _size : _uncompressed.size(); }
+
+    private:
+      friend class WebAssetStore;
+
+      bool                           _found = false;
+      const char*                    _data = nullptr;
+      uint64_t                       _size = 0;
+      std::shared_ptr<const Package> _package;
+      QByteArray                     _uncompressed;
+    };
+
+    void set_package(Package&& package);
+    bool has_package() const;
+
+    Asset find(const fc::path& filename) const;
+
+  private:
+    mutable std::mutex             _mutex;
+    std::shared_ptr<const Package> _package;
+};
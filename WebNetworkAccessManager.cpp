@@ -0,0 +1,275 @@
+#include "WebNetworkAccessManager.hpp"
+#include "ClientWrapper.hpp"
+#include "Metrics.hpp"
+#include "WebAssetStore.hpp"
+
+#include <QBuffer>
+#include <QFileInfo>
+#include <QNetworkReply>
+
+#include <fc/log/logger.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+
+namespace
+{
+
+QByteArray content_type(const QString& path)
+{
+  QString suffix = QFileInfo(path).suffix().toLower();
+  if (suffix == "html")
+    return "text/html; charset=utf-8";
+  if (suffix == "js")
+    return "application/javascript";
+  if (suffix == "css")
+    return "text/css";
+  if (suffix == "json")
+    return "application/json";
+  if (suffix == "svg")
+    return "image/svg+xml";
+  if (suffix == "png")
+    return "image/png";
+  //Let WebKit sniff everything else, as it did when the files came from the HTTP server
+  return QByteArray();
+}
+
+/// Reply carrying one file of the WebAssetStore.
+class AssetReply : public QNetworkReply
+{
+public:
+  AssetReply(QNetworkAccessManager::Operation op, const QNetworkRequest& request,
+             WebAssetStore::Asset asset, QObject* parent)
+    : QNetworkReply(parent),
+      _asset(std::move(asset))
+  {
+    setRequest(request);
+    setUrl(request.url());
+    setOperation(op);
+    open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+
+    setAttribute(QNetworkRequest::HttpStatusCodeAttribute, 200);
+    setAttribute(QNetworkRequest::HttpReasonPhraseAttribute, QByteArray("OK"));
+    setHeader(QNetworkRequest::ContentLengthHeader, qulonglong(_asset.size()));
+    QByteArray type = content_type(request.url().path());
+    if (!type.isEmpty())
+      setHeader(QNetworkRequest::ContentTypeHeader, type);
+    if (op == QNetworkAccessManager::HeadOperation)
+      _offset = _asset.size();
+
+    setFinished(true);
+    QMetaObject::invokeMethod(this, "metaDataChanged", Qt::QueuedConnection);
+    QMetaObject::invokeMethod(this, "readyRead", Qt::QueuedConnection);
+    QMetaObject::invokeMethod(this, "finished", Qt::QueuedConnection);
+  }
+
+  virtual void abort() override {}
+  virtual bool isSequential() const override { return true; }
+
+  virtual qint64 bytesAvailable() const override
+  {
+    return qint64(_asset.size() - _offset) + QNetworkReply::bytesAvailable();
+  }
+
+protected:
+  virtual qint64 readData(char* data, qint64 maxSize) override
+  {
+    if (_offset >= _asset.size())
+      return -1;
+    qint64 count = std::min<qint64>(maxSize, _asset.size() - _offset);
+    memcpy(data, _asset.data() + _offset, count);
+    _offset += count;
+    return count;
+  }
+
+private:
+  WebAssetStore::Asset _asset;
+  uint64_t             _offset = 0;
+};
+
+/// Reply standing in for a request to the HTTP server, which may only be sent later.
+class ForwardedReply : public QNetworkReply
+{
+public:
+  ForwardedReply(QNetworkAccessManager::Operation op, const QNetworkRequest& request, QObject* parent)
+    : QNetworkReply(parent)
+  {
+    setRequest(request);
+    setUrl(request.url());
+    setOperation(op);
+    open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+  }
+
+  void attach(QNetworkReply* inner)
+  {
+    _inner = inner;
+    _inner->setParent(this);
+
+    connect(_inner, &QNetworkReply::metaDataChanged, [this] {
+      copyMetaData();
+      Q_EMIT metaDataChanged();
+    });
+    connect(_inner, &QNetworkReply::readyRead, [this] {
+      _buffer += _inner->readAll();
+      Q_EMIT readyRead();
+    });
+    connect(_inner, &QNetworkReply::uploadProgress, this, &QNetworkReply::uploadProgress);
+    connect(_inner, &QNetworkReply::downloadProgress, this, &QNetworkReply::downloadProgress);
+    connect(_inner, &QNetworkReply::finished, [this] {
+      copyMetaData();
+      QByteArray rest = _inner->readAll();
+      if (_inner->error() != QNetworkReply::NoError)
+        setError(_inner->error(), _inner->errorString());
+      else if (url().path() == "/rpc")
+        Metrics::mark_milestone("first_rpc_answered");
+      setFinished(true);
+      if (!rest.isEmpty()) {
+        _buffer += rest;
+        Q_EMIT readyRead();
+      }
+      Q_EMIT finished();
+    });
+  }
+
+  virtual void abort() override
+  {
+    if (_inner) {
+      _inner->abort();
+      return;
+    }
+    //Still parked; it will never be sent
+    setError(QNetworkReply::OperationCanceledError, "Operation canceled");
+    setFinished(true);
+    QMetaObject::invokeMethod(this, "finished", Qt::QueuedConnection);
+  }
+
+  virtual bool isSequential() const override { return true; }
+
+  virtual qint64 bytesAvailable() const override
+  {
+    return _buffer.size() + QNetworkReply::bytesAvailable();
+  }
+
+protected:
+  virtual qint64 readData(char* data, qint64 maxSize) override
+  {
+    if (_buffer.isEmpty())
+      return isFinished() ? -1 : 0;
+    qint64 count = std::min<qint64>(maxSize, _buffer.size());
+    memcpy(data, _buffer.constData(), count);
+    _buffer.remove(0, count);
+    return count;
+  }
+
+private:
+  QNetworkReply* _inner = nullptr;
+  QByteArray     _buffer;
+
+  void copyMetaData()
+  {
+    setAttribute(QNetworkRequest::HttpStatusCodeAttribute, _inner->attribute(QNetworkRequest::HttpStatusCodeAttribute));
+    setAttribute(QNetworkRequest::HttpReasonPhraseAttribute, _inner->attribute(QNetworkRequest::HttpReasonPhraseAttribute));
+    for (const auto& header : _inner->rawHeaderPairs())
+      setRawHeader(header.first, header.second);
+  }
+};
+
+} // anonymous
+
+WebNetworkAccessManager::WebNetworkAccessManager(const WebAssetStore& assets, QObject* parent)
+  : QNetworkAccessManager(parent),
+    _assets(assets)
+{
+}
+
+void WebNetworkAccessManager::setRpcEndpoint(const QUrl& rpcUrl)
+{
+  _rpcUrl = rpcUrl;
+
+  ilog("Releasing ${n} requests parked during startup", ("n", _parkedRequests.size()));
+  auto parked = std::move(_parkedRequests);
+  _parkedRequests.clear();
+  for (const auto& send : parked)
+    send();
+}
+
+QNetworkReply* WebNetworkAccessManager::createRequest(Operation op, const QNetworkRequest& request, QIODevice* outgoingData)
+{
+  static const QUrl origin(ClientWrapper::ui_origin());
+  const QUrl& url = request.url();
+  if (url.scheme() != origin.scheme() || url.host() != origin.host() || url.port() != origin.port())
+    return QNetworkAccessManager::createRequest(op, request, outgoingData);
+
+  if (op == GetOperation || op == HeadOperation)
+  {
+    QString path = url.path();
+    while (path.startsWith('/'))
+      path.remove(0, 1);
+    if (path.isEmpty())
+      path = "index.html";
+
+    auto asset = _assets.find(fc::path(path.toStdString()));
+    if (asset.found())
+      return new AssetReply(op, request, std::move(asset), this);
+  }
+
+  return forward(op, request, outgoingData ? outgoingData->readAll() : QByteArray());
+}
+
+QNetworkReply* WebNetworkAccessManager::forward(Operation op, const QNetworkRequest& request, QByteArray body)
+{
+  QPointer<ForwardedReply> reply = new ForwardedReply(op, request, this);
+  if (request.url().path() == "/rpc") {
+    Q_EMIT rpcStarted();
+    //Exactly once, also for replies the page throws away before they finish
+    auto done = std::make_shared<bool>(false);
+    auto finish = [this, done] {
+      if (!*done) {
+        *done = true;
+        Q_EMIT rpcFinished();
+      }
+    };
+    connect(reply.data(), &QNetworkReply::finished, this, finish);
+    connect(reply.data(), &QObject::destroyed, this, finish);
+  }
+  //Only wallet calls can change what ClientWrapper keeps about the wallet
+  if (request.url().path() == "/rpc" && body.contains("\"wallet_"))
+    connect(reply.data(), &QNetworkReply::finished, this, [this, reply, body] {
+      if (reply && reply->error() == QNetworkReply::NoError)
+        Q_EMIT walletRpcSucceeded(body);
+    });
+
+  auto send = [this, reply, op, request, body] {
+    if (!reply || reply->isFinished())
+      return;
+
+    QUrl url = request.url();
+    url.setScheme(_rpcUrl.scheme());
+    url.setHost(_rpcUrl.host());
+    url.setPort(_rpcUrl.port());
+    QNetworkRequest serverRequest = request;
+    serverRequest.setUrl(url);
+    //Spare the server a 401 round trip
+    if (!serverRequest.hasRawHeader("Authorization"))
+      serverRequest.setRawHeader("Authorization",
+                                 "Basic " + (_rpcUrl.userName() + ":" + _rpcUrl.password()).toUtf8().toBase64());
+
+    QBuffer* upload = nullptr;
+    if (!body.isNull()) {
+      upload = new QBuffer;
+      upload->setData(body);
+      upload->open(QIODevice::ReadOnly);
+    }
+    QNetworkReply* inner = QNetworkAccessManager::createRequest(op, serverRequest, upload);
+    if (upload)
+      upload->setParent(inner);
+    reply->attach(inner);
+  };
+
+  if (_rpcUrl.isEmpty())
+    _parkedRequests.push_back(send);
+  else
+    send();
+  return reply;
+}
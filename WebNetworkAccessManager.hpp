@@ -0,0 +1,45 @@
+#pragma once
+
+#include <QByteArray>
+#include <QList>
+#include <QNetworkAccessManager>
+#include <QPointer>
+#include <QUrl>
+
+#include <functional>
+
+class WebAssetStore;
+
+/** Network access manager of the web view.
+    Requests to ClientWrapper::ui_origin() never touch the network: GETs for GUI files are
+    answered straight from the WebAssetStore, everything else (JSON-RPC) is forwarded to the
+    embedded HTTP server. Until that server is known, forwarded requests are parked, which
+    lets the GUI be loaded and its scripts run while the client is still replaying the chain.
+*/
+class WebNetworkAccessManager : public QNetworkAccessManager
+{
+  Q_OBJECT
+
+  public:
+    WebNetworkAccessManager(const WebAssetStore& assets, QObject* parent = nullptr);
+
+    /// Releases parked requests and forwards all further ones to the given server.
+    void setRpcEndpoint(const QUrl& rpcUrl);
+
+  Q_SIGNALS:
+    /// A JSON-RPC request calling wallet methods was answered without an HTTP error.
+    void walletRpcSucceeded(QByteArray request);
+    /// A JSON-RPC request was forwarded to the server, and it was answered (or failed, or was aborted).
+    void rpcStarted();
+    void rpcFinished();
+
+  protected:
+    virtual QNetworkReply* createRequest(Operation op, const QNetworkRequest& request, QIODevice* outgoingData) override;
+
+  private:
+    const WebAssetStore&          _assets;
+    QUrl                          _rpcUrl;
+    QList<std::function<void()>>  _parkedRequests;
+
+    QNetworkReply* forward(Operation op, const QNetworkRequest& request, QByteArray body);
+};
@@ -0,0 +1,191 @@
+#include "WebUpdates.hpp"
+
+#include <bts/utilities/git_revision.hpp>
+
+#include <fc/compress/lzma.hpp>
+#include <fc/io/raw_variant.hpp>
+#include <fc/log/logger.hpp>
+
+#include <QFile>
+#include <QRegExp>
+#include <QSysInfo>
+
+ClientVersion parseClientVersion(const QString& revisionDescription)
+{
+  ClientVersion version;
+  QRegExp versionMatcher(".*/(\\d+)\\.(\\d+)\\.(\\d+)(-([a-z]))?");
+  versionMatcher.indexIn(revisionDescription);
+  if (versionMatcher.pos(3) != -1)
+  {
+    version.majorVersion = versionMatcher.cap(1).toInt();
+    version.forkVersion = versionMatcher.cap(2).toInt();
+    version.minorVersion = versionMatcher.cap(3).toInt();
+  }
+  if (versionMatcher.pos(5) != -1)
+    version.patchVersion = versionMatcher.cap(5).toStdString()[0];
+  return version;
+}
+
+QUrl webUpdatesManifestUrl(const QUuid& appId, const QString& version)
+{
+  QString queryString = QString("?uuid=%1&version=%2").arg(appId.toString().mid(1,36), version);
+
+#if QT_VERSION >= 0x050400
+  queryString += QString("&platform=%1").arg(QSysInfo::prettyProductName());
+#endif
+
+#ifdef Q_OS_LINUX
+  queryString += QString("&os=linux");
+#elif defined(Q_OS_WIN32)
+  queryString += QString("&os=windows");
+#elif defined(Q_OS_MAC)
+  queryString += QString("&os=mac");
+#else
+  queryString += QString("&os=unknown");
+#endif
+
+  return QUrl(WEB_UPDATES_MANIFEST_URL + queryString);
+}
+
+bool findWebUpdate(const WebUpdateManifest& manifest, const ClientVersion& running, WebUpdateManifest::UpdateDetails& update)
+{
+  WebUpdateManifest::UpdateDetails bound;
+  bound.majorVersion = running.majorVersion;
+  bound.forkVersion = running.forkVersion;
+  bound.minorVersion = running.minorVersion + 1;
+
+  auto itr = manifest.updates.lower_bound(bound);
+  if (itr == manifest.updates.begin())
+    return false;
+  --itr;
+  if (itr->majorVersion != running.majorVersion || itr->forkVersion != running.forkVersion
+          || itr->minorVersion != running.minorVersion || itr->patchVersion <= running.patchVersion
+          || itr->signatures.size() < WEB_UPDATES_SIGNATURE_REQUIREMENT)
+    return false;
+
+  update = *itr;
+  return true;
+}
+
+bool verifyWebUpdateSignature(const WebUpdateManifest::UpdateDetails& description, const QByteArray& updatePackage)
+{
+  return verifyWebUpdateSignature(description, updatePackage, WEB_UPDATES_SIGNING_KEYS);
+}
+
+bool verifyWebUpdateSignature(const WebUpdateManifest::UpdateDetails& description, const QByteArray& updatePackage,
+                              const std::unordered_set<bts::blockchain::address>& signingKeys)
+{
+  if (description.signatures.size() < WEB_UPDATES_SIGNATURE_REQUIREMENT
+          || signingKeys.size() < WEB_UPDATES_SIGNATURE_REQUIREMENT) {
+      elog("Rejecting update signature: insufficient signatures in manifest.");
+      return false;
+  }
+  if (description.timestamp < fc::time_point_sec(bts::utilities::git_revision_unix_timestamp)) {
+      elog("Rejecting update signature: timestamp older than build.");
+      return false;
+  }
+
+  elog("The size of the update package is ${s}", ("s", updatePackage.size()));
+
+  fc::sha256::encoder enc;
+  enc.write(updatePackage.data(), updatePackage.size());
+  std::string desc = description.signable_string();
+  enc.write(desc.c_str(), desc.size());
+  auto hash = enc.result();
+
+  auto authorized_signers = signingKeys;
+  for (auto signature : description.signatures)
+  {
+    authorized_signers.erase(bts::blockchain::address(fc::ecc::public_key(signature, hash, false)));
+    elog("The address of the update package is ${s}", ("s", bts::blockchain::address(fc::ecc::public_key(signature, hash, false))));
+  }
+  if ((signingKeys.size() - authorized_signers.size()) >= WEB_UPDATES_SIGNATURE_REQUIREMENT)
+    return true;
+  elog("Rejecting update signature: signature requirement failed (got ${match}/${req} matches)", ("match", signingKeys.size() - authorized_signers.size())("req", WEB_UPDATES_SIGNATURE_REQUIREMENT));
+  return false;
+}
+
+bool unpackWebUpdate(const QByteArray& updatePackage, WebPackageFiles& files)
+{
+  using std::vector;
+  using std::string;
+  using std::pair;
+
+  vector<char> decompressedStream;
+  try {
+    decompressedStream = fc::lzma_decompress(vector<char>(updatePackage.begin(), updatePackage.end()));
+  } catch (fc::exception e) {
+    elog("Failed to decompress web update package: ${error}", ("error", e.to_detail_string()));
+    return false;
+  }
+
+  vector<pair<string, vector<char>>> deserializedPackage;
+  try {
+    fc::datastream<const char*> ds(decompressedStream.data(), decompressedStream.size());
+    fc::raw::unpack(ds, deserializedPackage);
+    decompressedStream.clear();
+  } catch (fc::exception e) {
+    elog("Failed to deserialize web update package: ${error}", ("error", e.to_detail_string()));
+    return false;
+  }
+
+  files.clear();
+  for (auto& file : deserializedPackage)
+    files[std::move(file.first)] = std::move(file.second);
+  return true;
+}
+
+void removeIncompleteWebUpdate(QDir dataDir)
+{
+  if (dataDir.exists("web.json") ^ dataDir.exists("web.dat"))
+  {
+    if (dataDir.exists("web.json")) {
+      elog("Found web.json but not web.dat. Deleting.");
+      dataDir.remove("web.json");
+    }
+    if (dataDir.exists("web.dat")) {
+      elog("Found web.dat but not web.json. Deleting.");
+      dataDir.remove("web.dat");
+    }
+  }
+}
+
+bool installWebUpdate(QDir dataDir, const WebUpdateManifest::UpdateDetails& description, const QByteArray& updatePackage)
+{
+  QFile webPackage(dataDir.absoluteFilePath("web.dat"));
+  if (!webPackage.open(QIODevice::WriteOnly) || webPackage.write(updatePackage) != updatePackage.size()) {
+    elog("Unable to write web update package to ${path}", ("path", dataDir.absoluteFilePath("web.dat").toStdString()));
+    return false;
+  }
+  fc::json::save_to_file(fc::variant(description), fc::path(dataDir.absoluteFilePath("web.json").toStdWString()));
+  wlog("Downloaded new web package.");
+  return true;
+}
+
+bool loadInstalledWebUpdate(QDir dataDir, WebUpdateManifest::UpdateDetails& description, WebPackageFiles& files)
+{
+  if (!dataDir.exists("web.json")) {
+    wlog("No web update package found.");
+    return false;
+  }
+  if (!dataDir.exists("web.dat")) {
+    elog("Found web update package description, but not the package itself.");
+    return false;
+  }
+
+  description = fc::json::from_file(fc::path(dataDir.absoluteFilePath("web.json").toStdWString())).as<WebUpdateManifest::UpdateDetails>();
+
+  QByteArray updatePackage;
+  QFile packageFile(dataDir.absoluteFilePath("web.dat"));
+  packageFile.open(QIODevice::ReadOnly);
+  updatePackage = packageFile.readAll();
+
+  if (!verifyWebUpdateSignature(description, updatePackage)) {
+    elog("Found web update package on disk, but it's signature doesn't check out. Removing it.");
+    dataDir.remove("web.json");
+    dataDir.remove("web.dat");
+    return false;
+  }
+
+  return unpackWebUpdate(updatePackage, files);
+}
@@ -7,7 +7,15 @@
 #include <fc/reflect/reflect.hpp>
 #include <fc/time.hpp>
 
+#include <QByteArray>
+#include <QDir>
+#include <QString>
+#include <QUrl>
+#include <QUuid>
+
 #include <set>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 const static char*                                          WEB_UPDATES_MANIFEST_URL = "http://dacplay.org/manifest.json";
@@ -63,7 +71,7 @@ struct WebUpdateManifest
             return patchVersion < other.patchVersion;
         }
 
-        std::string signable_string() {
+        std::string signable_string() const {
             UpdateDetails ud = *this;
             ud.signatures.clear();
             return fc::json::to_string(ud);
@@ -73,5 +81,37 @@ struct WebUpdateManifest
     std::set<UpdateDetails> updates;
 };
 
+//Files of an unpacked web update package, keyed by their path below htdocs.
+typedef std::unordered_map<std::string, std::vector<char>> WebPackageFiles;
+
+//Version of the running client; zero where the build is not a tagged release.
+struct ClientVersion
+{
+    uint8_t majorVersion = 0;
+    uint8_t forkVersion = 0;
+    uint8_t minorVersion = 0;
+    uint8_t patchVersion = 0;
+};
+
+//The update logic below is shared by the GUI and the headless daemon; all dialogs stay with the callers.
+
+//Parses a release tag, which will look like bts/0.4.28 or dvs/0.4.29-b.
+ClientVersion parseClientVersion(const QString& revisionDescription);
+QUrl webUpdatesManifestUrl(const QUuid& appId, const QString& version);
+//Picks the newest update applicable to the running version from the manifest. Returns false if there is none.
+bool findWebUpdate(const WebUpdateManifest& manifest, const ClientVersion& running, WebUpdateManifest::UpdateDetails& update);
+bool verifyWebUpdateSignature(const WebUpdateManifest::UpdateDetails& description, const QByteArray& updatePackage);
+//As above, against the given signing keys instead of WEB_UPDATES_SIGNING_KEYS.
+bool verifyWebUpdateSignature(const WebUpdateManifest::UpdateDetails& description, const QByteArray& updatePackage,
+                              const std::unordered_set<bts::blockchain::address>& signingKeys);
+bool unpackWebUpdate(const QByteArray& updatePackage, WebPackageFiles& files);
+
+//Deletes web.json or web.dat from the data dir if the other one is missing.
+void removeIncompleteWebUpdate(QDir dataDir);
+//Stores a verified package and its description as web.dat and web.json.
+bool installWebUpdate(QDir dataDir, const WebUpdateManifest::UpdateDetails& description, const QByteArray& updatePackage);
+//Reads, verifies and unpacks the installed package; one whose signature doesn't check out is removed.
+bool loadInstalledWebUpdate(QDir dataDir, WebUpdateManifest::UpdateDetails& description, WebPackageFiles& files);
+
 FC_REFLECT(WebUpdateManifest::UpdateDetails, (majorVersion)(forkVersion)(minorVersion)(patchVersion)(signatures)(releaseNotes)(updatePackageUrl)(timestamp))
 FC_REFLECT(WebUpdateManifest, (updates))
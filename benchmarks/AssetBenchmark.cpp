@@ -0,0 +1,182 @@
+// Replays a page-load request trace against the asset lookup get_htdocs_file performs, for
+// files served from the QRC and from an installed web update package, on one thread and on
+// several at once. Each request looks the file up in WebAssetStore and copies it into a
+// response buffer, as get_htdocs_file does before handing it to the HTTP server.
+//
+// Usage: asset_benchmark [--trace file] [--iterations N] [--threads N]
+// The trace holds one path below htdocs per line; lines starting with # are skipped.
+
+#include "WebAssetStore.hpp"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QResource>
+#include <QStringList>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <thread>
+#include <vector>
+
+#ifndef ASSET_BENCHMARK_TRACE
+#define ASSET_BENCHMARK_TRACE "page_load_trace.txt"
+#endif
+
+//Counts every allocation in the process, to report allocations per request
+static std::atomic<uint64_t> g_allocations(0);
+
+void* operator new(std::size_t size)
+{
+  ++g_allocations;
+  if (void* p = std::malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+  std::free(p);
+}
+
+namespace
+{
+
+typedef std::chrono::steady_clock Clock;
+
+struct Result
+{
+  std::vector<double> latencies;
+  uint64_t            bytes = 0;
+};
+
+int argumentValue(const QStringList& arguments, const QString& name, int defaultValue)
+{
+  int index = arguments.indexOf(name);
+  if (index != -1 && arguments.size() > index + 1)
+    return arguments[index + 1].toInt();
+  return defaultValue;
+}
+
+std::vector<fc::path> loadTrace(const QString& fileName)
+{
+  std::vector<fc::path> trace;
+  QFile file(fileName);
+  if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    return trace;
+  while (!file.atEnd())
+  {
+    QByteArray line = file.readLine().trimmed();
+    if (!line.isEmpty() && !line.startsWith('#'))
+      trace.push_back(fc::path(line.toStdString()));
+  }
+  return trace;
+}
+
+/// Builds a package holding the traced files, so both sources serve identical bytes.
+WebAssetStore::Package packageFromQrc(const std::vector<fc::path>& trace)
+{
+  WebAssetStore qrc;
+  WebAssetStore::Package package;
+  for (const fc::path& path : trace)
+  {
+    auto asset = qrc.find(path);
+    if (asset.found())
+      package[path.to_native_ansi_path()] = std::vector<char>(asset.data(), asset.data() + asset.size());
+  }
+  return package;
+}
+
+Result replay(const WebAssetStore& store, const std::vector<fc::path>& trace, int iterations)
+{
+  Result result;
+  result.latencies.reserve(trace.size() * iterations);
+  std::vector<char> response;
+  for (int i = 0; i < iterations; ++i)
+    for (const fc::path& path : trace)
+    {
+      auto start = Clock::now();
+      auto asset = store.find(path);
+      if (asset.found()) {
+        response.assign(asset.data(), asset.data() + asset.size());
+        result.bytes += asset.size();
+      }
+      result.latencies.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+    }
+  return result;
+}
+
+void run(const char* name, const WebAssetStore& store, const std::vector<fc::path>& trace, int iterations, int threads)
+{
+  std::vector<Result> results(threads);
+  uint64_t allocationsBefore = g_allocations;
+  auto start = Clock::now();
+
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; ++t)
+    workers.emplace_back([&, t] { results[t] = replay(store, trace, iterations); });
+  for (auto& worker : workers)
+    worker.join();
+
+  double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  uint64_t allocations = g_allocations - allocationsBefore;
+
+  std::vector<double> latencies;
+  uint64_t bytes = 0;
+  for (auto& result : results)
+  {
+    latencies.insert(latencies.end(), result.latencies.begin(), result.latencies.end());
+    bytes += result.bytes;
+  }
+  std::sort(latencies.begin(), latencies.end());
+  if (latencies.empty())
+    return;
+
+  std::cout << name << ", " << threads << " thread(s)\n"
+            << "  " << latencies.size() / seconds << " req/s, "
+            << bytes / seconds / (1024 * 1024) << " MB/s\n"
+            << "  latency p50=" << latencies[latencies.size() / 2] << "us"
+            << " p99=" << latencies[latencies.size() * 99 / 100] << "us"
+            << " max=" << latencies.back() << "us\n"
+            << "  allocations per request: " << double(allocations) / latencies.size() << "\n";
+}
+
+} // anonymous
+
+int main(int argc, char** argv)
+{
+  QCoreApplication app(argc, argv);
+  const QStringList arguments = app.arguments();
+  const int iterations = argumentValue(arguments, "--iterations", 200);
+  const int threads = std::max(1, argumentValue(arguments, "--threads", int(std::thread::hardware_concurrency())));
+  int traceIndex = arguments.indexOf("--trace");
+  QString traceFile = traceIndex != -1 && arguments.size() > traceIndex + 1 ? arguments[traceIndex + 1] : QString(ASSET_BENCHMARK_TRACE);
+
+  std::vector<fc::path> trace = loadTrace(traceFile);
+  if (trace.empty()) {
+    std::cerr << "No requests in trace " << traceFile.toStdString() << std::endl;
+    return 1;
+  }
+
+  WebAssetStore qrc;
+  WebAssetStore package;
+  package.set_package(packageFromQrc(trace));
+
+  int missing = 0;
+  for (const fc::path& path : trace)
+    if (!qrc.find(path).found()) {
+      std::cerr << "Not in QRC: " << path.generic_string() << "\n";
+      ++missing;
+    }
+
+  std::cout << trace.size() << " requests per page load (" << missing << " missing), "
+            << iterations << " page loads per thread\n";
+  run("QRC", qrc, trace, iterations, 1);
+  run("QRC", qrc, trace, iterations, threads);
+  run("web package", package, trace, iterations, 1);
+  run("web package", package, trace, iterations, threads);
+  return 0;
+}
@@ -0,0 +1,149 @@
+// Times how long startup takes to reach enough seed peers, with the seed list dialed one at
+// a time (what the wallet used to do) and several at a time by PeerDialer, before and after
+// it has a history to rank the seeds by. Seeds are local stand-ins: live ones are TCP
+// listeners on the loopback, dead ones are either closed loopback ports (refused at once) or
+// TEST-NET addresses that never answer, so each costs a full timeout. Dead seeds come first
+// in the list, as they would when the first few seed nodes are down.
+//
+// Usage: peer_dial_benchmark [--live N] [--refused N] [--silent N] [--wanted N] [--parallel N]
+//                            [--timeout-ms N] [--runs N]
+
+#include "PeerDialer.hpp"
+
+#include <fc/network/tcp_socket.hpp>
+#include <fc/thread/thread.hpp>
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QStringList>
+#include <QTemporaryDir>
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+int argumentValue(const QStringList& arguments, const QString& name, int defaultValue)
+{
+  int index = arguments.indexOf(name);
+  if (index != -1 && arguments.size() > index + 1)
+    return arguments[index + 1].toInt();
+  return defaultValue;
+}
+
+/// A listener that accepts and drops connections, which is all a probe needs of a peer.
+struct StandInPeer
+{
+  fc::tcp_server   server;
+  fc::future<void> accepting;
+
+  StandInPeer()
+  {
+    server.listen(0);
+    accepting = fc::async([this] {
+      while (true)
+      {
+        fc::tcp_socket socket;
+        server.accept(socket);
+      }
+    }, "stand-in peer");
+  }
+
+  ~StandInPeer()
+  {
+    accepting.cancel();
+    server.close();
+    try { accepting.wait(); } catch (const fc::exception&) {}
+  }
+
+  std::string endpoint() const { return "127.0.0.1:" + std::to_string(server.get_port()); }
+};
+
+/// A loopback port nothing listens on: bound and released again.
+std::string refusedEndpoint()
+{
+  fc::tcp_server server;
+  server.listen(0);
+  std::string endpoint = "127.0.0.1:" + std::to_string(server.get_port());
+  server.close();
+  return endpoint;
+}
+
+void report(const std::string& name, std::vector<double> samples, uint32_t connected, uint32_t failed)
+{
+  std::sort(samples.begin(), samples.end());
+  double total = 0;
+  for (double sample : samples)
+    total += sample;
+
+  std::cout << "  " << name << ": n=" << samples.size()
+            << " mean=" << total / samples.size() << "ms"
+            << " p50=" << samples[samples.size() / 2] << "ms"
+            << " max=" << samples.back() << "ms"
+            << " (last run: " << connected << " connected, " << failed << " failed probes)\n";
+}
+
+} // anonymous
+
+int main(int argc, char** argv)
+{
+  QCoreApplication app(argc, argv);
+  const QStringList arguments = app.arguments();
+  const int live = std::max(1, argumentValue(arguments, "--live", 6));
+  const int refused = argumentValue(arguments, "--refused", 4);
+  const int silent = argumentValue(arguments, "--silent", 4);
+  const int runs = std::max(1, argumentValue(arguments, "--runs", 5));
+
+  PeerDialer::config config;
+  config.wanted = uint32_t(std::max(1, argumentValue(arguments, "--wanted", 4)));
+  config.parallel = uint32_t(std::max(1, argumentValue(arguments, "--parallel", 8)));
+  config.timeout = fc::milliseconds(std::max(1, argumentValue(arguments, "--timeout-ms", 2000)));
+
+  QTemporaryDir workDir;
+  fc::thread dialerThread("dialer");
+  dialerThread.async([&] {
+    std::vector<std::unique_ptr<StandInPeer>> standIns;
+    std::vector<std::string> seeds;
+    for (int i = 0; i < silent; ++i)
+      seeds.push_back("192.0.2." + std::to_string(i + 1) + ":1776");
+    for (int i = 0; i < refused; ++i)
+      seeds.push_back(refusedEndpoint());
+    for (int i = 0; i < live; ++i)
+    {
+      standIns.emplace_back(new StandInPeer);
+      seeds.push_back(standIns.back()->endpoint());
+    }
+
+    std::cout << seeds.size() << " seeds (" << silent << " silent, " << refused << " refused, " << live << " live), "
+              << config.wanted << " wanted, " << config.timeout.count() / 1000 << "ms timeout, " << runs << " runs\n";
+
+    auto measure = [&](const std::string& name, PeerDialer::config c, bool keepHistory) {
+      std::vector<double> samples;
+      PeerDialer::result last;
+      fc::path history = keepHistory ? fc::path(QDir(workDir.path()).filePath(QString::fromStdString(name + ".json")).toStdWString())
+                                     : fc::path();
+      //The history is warmed by one run that isn't counted
+      if (keepHistory)
+        PeerDialer(history, c).dial(seeds, [](const std::string&) {});
+      for (int run = 0; run < runs; ++run)
+      {
+        PeerDialer dialer(history, c);
+        last = dialer.dial(seeds, [](const std::string&) {});
+        samples.push_back(last.elapsed.count() / 1000.0);
+      }
+      report(name, samples, uint32_t(last.connected.size()), last.failed);
+    };
+
+    PeerDialer::config sequential = config;
+    sequential.parallel = 1;
+    measure("one at a time, no history", sequential, false);
+    measure("one at a time, with history", sequential, true);
+    measure(std::to_string(config.parallel) + " at a time, no history", config, false);
+    measure(std::to_string(config.parallel) + " at a time, with history", config, true);
+  }).wait();
+  return 0;
+}
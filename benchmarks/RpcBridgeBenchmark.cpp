@@ -0,0 +1,252 @@
+// Compares the ways the web GUI can reach the client: JSON-RPC over the loopback HTTP server
+// (what it does today), direct calls through the ClientWrapper bridge, and batches of calls
+// through the bridge. Each path runs the same mix of GUI calls: get_info polling, balance
+// lookups and pages of transaction history. Reports throughput, latency per call kind, and
+// CPU per call on the GUI thread and on the remaining threads (the bitshares thread and the
+// HTTP server's).
+//
+// Usage: rpc_bridge_benchmark [--calls N] [--concurrency N] [--batch N] [--account name]
+//                             (--mock-client script.json | --data-dir dir)
+// The client is started by ClientWrapper exactly as in the wallet, so --mock-client and
+// --data-dir are read from the command line by it. A real data dir needs an open wallet.
+
+#include "ClientWrapper.hpp"
+
+#include <fc/thread/thread.hpp>
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QStringList>
+#include <QTimer>
+
+#include <algorithm>
+#include <ctime>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+struct Call
+{
+  const char*  kind;
+  QString      method;
+  QVariantList params;
+};
+
+struct Run
+{
+  std::map<std::string, std::vector<double>> latencies;
+  double seconds = 0;
+  double guiCpuMs = 0;
+  double otherCpuMs = 0;
+  int    calls = 0;
+  int    errors = 0;
+};
+
+int argumentValue(const QStringList& arguments, const QString& name, int defaultValue)
+{
+  int index = arguments.indexOf(name);
+  if (index != -1 && arguments.size() > index + 1)
+    return arguments[index + 1].toInt();
+  return defaultValue;
+}
+
+/// Six polls, three balance lookups and one history page out of every ten calls, roughly what the GUI does while idle on the accounts page.
+std::vector<Call> callMix(int count, const QString& account)
+{
+  std::vector<Call> calls;
+  for (int i = 0; i < count; ++i)
+  {
+    switch (i % 10)
+    {
+    case 0: case 2: case 4: case 6: case 8: case 9:
+      calls.push_back({"get_info", "get_info", QVariantList()});
+      break;
+    case 1: case 5: case 7:
+      calls.push_back({"balance", "wallet_account_balance", QVariantList() << account});
+      break;
+    default:
+      calls.push_back({"history", "wallet_account_transaction_history", QVariantList() << account << "" << 50 << 0 << -1});
+    }
+  }
+  return calls;
+}
+
+double cpuMs(bool currentThreadOnly)
+{
+#ifdef Q_OS_UNIX
+  timespec time;
+  clock_gettime(currentThreadOnly ? CLOCK_THREAD_CPUTIME_ID : CLOCK_PROCESS_CPUTIME_ID, &time);
+  return time.tv_sec * 1000.0 + time.tv_nsec / 1000000.0;
+#else
+  return 0;
+#endif
+}
+
+/// Times the calls and charges the CPU used meanwhile to the GUI thread and to everything else.
+template<typename Work>
+Run measure(Work&& work)
+{
+  Run run;
+  double guiStart = cpuMs(true);
+  double processStart = cpuMs(false);
+  QElapsedTimer timer;
+  timer.start();
+  work(run);
+  run.seconds = timer.nsecsElapsed() / 1e9;
+  run.guiCpuMs = cpuMs(true) - guiStart;
+  run.otherCpuMs = cpuMs(false) - processStart - run.guiCpuMs;
+  return run;
+}
+
+/// JSON-RPC over HTTP, keeping up to `concurrency` requests in flight like WebKit does per host.
+Run runHttp(ClientWrapper& client, const std::vector<Call>& calls, int concurrency)
+{
+  QNetworkAccessManager network;
+  QUrl url = client.rpc_url();
+  QByteArray authorization = "Basic " + (url.userName() + ":" + url.password()).toUtf8().toBase64();
+  url.setUserInfo(QString());
+
+  return measure([&](Run& run) {
+    QEventLoop loop;
+    size_t next = 0;
+    int inFlight = 0;
+    std::function<void()> sendNext = [&] {
+      while (inFlight < concurrency && next < calls.size())
+      {
+        const Call& call = calls[next];
+        QJsonObject body{{"jsonrpc", "2.0"}, {"id", int(next)}, {"method", call.method},
+                         {"params", QJsonArray::fromVariantList(call.params)}};
+        ++next;
+        ++inFlight;
+
+        QNetworkRequest request(url);
+        request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+        request.setRawHeader("Authorization", authorization);
+        const char* kind = call.kind;
+        auto started = std::make_shared<QElapsedTimer>();
+        started->start();
+        QNetworkReply* reply = network.post(request, QJsonDocument(body).toJson(QJsonDocument::Compact));
+        QObject::connect(reply, &QNetworkReply::finished, [&, reply, started, kind] {
+          run.latencies[kind].push_back(started->nsecsElapsed() / 1000000.0);
+          ++run.calls;
+          if (reply->error() != QNetworkReply::NoError || QJsonDocument::fromJson(reply->readAll()).object().contains("error"))
+            ++run.errors;
+          reply->deleteLater();
+          --inFlight;
+          if (next == calls.size() && inFlight == 0)
+            loop.quit();
+          else
+            sendNext();
+        });
+      }
+    };
+    sendNext();
+    loop.exec();
+  });
+}
+
+Run runBridge(ClientWrapper& client, const std::vector<Call>& calls)
+{
+  return measure([&](Run& run) {
+    QElapsedTimer started;
+    for (const Call& call : calls)
+    {
+      started.start();
+      QVariantMap response = client.call(call.method, call.params).toMap();
+      run.latencies[call.kind].push_back(started.nsecsElapsed() / 1000000.0);
+      ++run.calls;
+      if (response.contains("error"))
+        ++run.errors;
+    }
+  });
+}
+
+/// Latencies are per batch, as a batch is answered as a whole.
+Run runBatches(ClientWrapper& client, const std::vector<Call>& calls, int batchSize)
+{
+  return measure([&](Run& run) {
+    QElapsedTimer started;
+    for (size_t first = 0; first < calls.size(); first += batchSize)
+    {
+      QVariantList batch;
+      for (size_t i = first; i < std::min(calls.size(), first + batchSize); ++i)
+        batch.push_back(QVariantMap{{"method", calls[i].method}, {"params", calls[i].params}});
+
+      started.start();
+      QVariantList responses = client.call_batch(batch);
+      run.latencies["batch"].push_back(started.nsecsElapsed() / 1000000.0);
+      run.calls += batch.size();
+      for (const QVariant& response : responses)
+        if (response.toMap().contains("error"))
+          ++run.errors;
+    }
+  });
+}
+
+void report(const std::string& name, const Run& run)
+{
+  std::cout << name << "\n"
+            << "  " << run.calls / run.seconds << " calls/s, " << run.errors << " errors\n"
+            << "  cpu per call: gui thread=" << run.guiCpuMs / run.calls << "ms"
+            << " other threads=" << run.otherCpuMs / run.calls << "ms\n";
+  for (auto entry : run.latencies)
+  {
+    std::vector<double>& samples = entry.second;
+    std::sort(samples.begin(), samples.end());
+    std::cout << "  " << entry.first << ": n=" << samples.size()
+              << " p50=" << samples[samples.size() / 2] << "ms"
+              << " p99=" << samples[samples.size() * 99 / 100] << "ms"
+              << " max=" << samples.back() << "ms\n";
+  }
+}
+
+} // anonymous
+
+int main(int argc, char** argv)
+{
+  QCoreApplication app(argc, argv);
+  const QStringList arguments = app.arguments();
+  const int callCount = std::max(1, argumentValue(arguments, "--calls", 2000));
+  const int concurrency = std::max(1, argumentValue(arguments, "--concurrency", 6));
+  const int batchSize = std::max(1, argumentValue(arguments, "--batch", 10));
+  int accountIndex = arguments.indexOf("--account");
+  QString account = accountIndex != -1 && arguments.size() > accountIndex + 1 ? arguments[accountIndex + 1] : QString();
+
+  //As in the wallet: let fc tasks scheduled on the GUI thread run
+  QTimer fc_tasks;
+  QObject::connect(&fc_tasks, &QTimer::timeout, [] { fc::usleep(fc::microseconds(1000)); });
+  fc_tasks.start(33);
+
+  ClientWrapper client;
+  QEventLoop startup;
+  QObject::connect(&client, &ClientWrapper::initialized, &startup, &QEventLoop::quit);
+  QObject::connect(&client, &ClientWrapper::error, [&](QString message) {
+    std::cerr << message.toStdString() << std::endl;
+    startup.exit(1);
+  });
+  client.initialize(nullptr);
+  if (startup.exec() != 0)
+    return 1;
+
+  const std::vector<Call> calls = callMix(callCount, account);
+  std::cout << callCount << " calls per path\n";
+  report("HTTP loopback, 1 in flight", runHttp(client, calls, 1));
+  report("HTTP loopback, " + std::to_string(concurrency) + " in flight", runHttp(client, calls, concurrency));
+  report("bridge", runBridge(client, calls));
+  report("bridge, batches of " + std::to_string(batchSize), runBatches(client, calls, batchSize));
+
+  fc_tasks.stop();
+  return client.shutdown() ? 0 : 1;
+}
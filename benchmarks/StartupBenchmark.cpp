@@ -0,0 +1,163 @@
+// Launches the wallet repeatedly and reports how long each startup milestone takes, from
+// spawning the process to the first answered RPC call of the web GUI. The wallet records the
+// milestones itself (see Metrics::mark_milestone) and writes them out when started with
+// --startup-report <file>, quitting as soon as it is interactive.
+//
+// Usage: startup_benchmark --app <path to wallet> [--runs N] [--timeout s] [--fixture dir] [-- wallet arguments]
+// --fixture copies the given data dir afresh for every run, so each one replays the same chain.
+// Pass "-- --mock-client script.json" to measure the GUI startup path without a real chain.
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QProcess>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <QVariantMap>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <vector>
+
+namespace
+{
+
+//In the order they are normally reached
+const char* const MILESTONES[] = {
+  "launch", "splash_shown", "client_open", "httpd_ready", "initialized",
+  "web_view_loaded", "interactive", "first_rpc_answered"
+};
+
+QString argumentString(const QStringList& arguments, const QString& name, const QString& defaultValue = QString())
+{
+  int index = arguments.indexOf(name);
+  if (index != -1 && arguments.size() > index + 1)
+    return arguments[index + 1];
+  return defaultValue;
+}
+
+bool copyDirectory(const QString& source, const QString& destination)
+{
+  QDir sourceDir(source);
+  if (!sourceDir.exists())
+    return false;
+
+  QDirIterator files(source, QDir::Files | QDir::Hidden | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+  while (files.hasNext())
+  {
+    QString file = files.next();
+    QString target = QDir(destination).filePath(sourceDir.relativeFilePath(file));
+    if (!QDir().mkpath(QFileInfo(target).absolutePath()) || !QFile::copy(file, target))
+      return false;
+  }
+  return true;
+}
+
+void report(const char* name, std::vector<double> samples)
+{
+  if (samples.empty())
+  {
+    std::cout << "  " << name << ": not reached\n";
+    return;
+  }
+
+  std::sort(samples.begin(), samples.end());
+  double total = 0;
+  for (double sample : samples)
+    total += sample;
+  double mean = total / samples.size();
+  double variance = 0;
+  for (double sample : samples)
+    variance += (sample - mean) * (sample - mean);
+
+  std::cout << "  " << name << ": n=" << samples.size()
+            << " mean=" << mean << "ms"
+            << " stddev=" << std::sqrt(variance / samples.size()) << "ms"
+            << " min=" << samples.front() << "ms"
+            << " p50=" << samples[samples.size() / 2] << "ms"
+            << " p90=" << samples[samples.size() * 9 / 10] << "ms"
+            << " max=" << samples.back() << "ms\n";
+}
+
+} // anonymous
+
+int main(int argc, char** argv)
+{
+  QCoreApplication app(argc, argv);
+  QStringList arguments = app.arguments();
+  QStringList walletArguments;
+  int separator = arguments.indexOf("--");
+  if (separator != -1)
+  {
+    walletArguments = arguments.mid(separator + 1);
+    arguments = arguments.mid(0, separator);
+  }
+
+  const QString wallet = argumentString(arguments, "--app");
+  const int runs = std::max(1, argumentString(arguments, "--runs", "10").toInt());
+  const int timeoutMs = argumentString(arguments, "--timeout", "600").toInt() * 1000;
+  const QString fixture = argumentString(arguments, "--fixture");
+  if (wallet.isEmpty()) {
+    std::cerr << "Usage: startup_benchmark --app <path to wallet> [--runs N] [--timeout s] [--fixture dir] [-- wallet arguments]" << std::endl;
+    return 1;
+  }
+
+  std::map<std::string, std::vector<double>> samples;
+  int failures = 0;
+  for (int run = 0; run < runs; ++run)
+  {
+    QTemporaryDir workDir;
+    QStringList runArguments = walletArguments;
+    if (!fixture.isEmpty())
+    {
+      QString dataDir = QDir(workDir.path()).filePath("data");
+      if (!copyDirectory(fixture, dataDir)) {
+        std::cerr << "Unable to copy fixture " << fixture.toStdString() << std::endl;
+        return 1;
+      }
+      runArguments << "--data-dir" << dataDir;
+    }
+    QString reportPath = QDir(workDir.path()).filePath("startup.json");
+    runArguments << "--startup-report" << reportPath;
+
+    QProcess process;
+    process.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    qint64 spawnedAt = QDateTime::currentMSecsSinceEpoch();
+    process.start(wallet, runArguments);
+    if (!process.waitForFinished(timeoutMs))
+    {
+      std::cerr << "Run " << run + 1 << " did not become interactive within the timeout" << std::endl;
+      process.kill();
+      process.waitForFinished();
+      ++failures;
+      continue;
+    }
+
+    QFile reportFile(reportPath);
+    if (!reportFile.open(QIODevice::ReadOnly))
+    {
+      std::cerr << "Run " << run + 1 << " exited with code " << process.exitCode() << " without a report" << std::endl;
+      ++failures;
+      continue;
+    }
+
+    //Milestones count from the wallet's own start; shift them so they count from spawning it
+    QVariantMap milestones = QJsonDocument::fromJson(reportFile.readAll()).toVariant().toMap();
+    double launch = milestones.take("process_start_epoch_ms").toLongLong() - spawnedAt;
+    samples["launch"].push_back(launch);
+    for (auto milestone = milestones.begin(); milestone != milestones.end(); ++milestone)
+      samples[milestone.key().toStdString()].push_back(launch + milestone.value().toDouble());
+  }
+
+  std::cout << wallet.toStdString() << " " << walletArguments.join(' ').toStdString() << "\n"
+            << runs << " runs, " << failures << " failed; times from spawning the process\n";
+  for (const char* milestone : MILESTONES)
+    report(milestone, samples[milestone]);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,204 @@
+// Times catching up a fixture chain from local stand-in peers, the way ClientWrapper::catch_up
+// does it: one range at a time from one source (fetching and applying take turns), and through
+// BlockPipeline from several sources at once with a reorder buffer feeding the applier. The
+// stand-ins are HTTP servers on the loopback that answer the same /blocks requests as a wallet
+// with sync/serve_blocks on, after a scripted round trip and at a scripted upload rate each, as
+// peers on a real network would. Applying a block spins for --apply-us, like validation does.
+// Optionally some sources fail every request, to show ranges being retried elsewhere.
+//
+// Usage: sync_pipeline_benchmark [--blocks N] [--transactions N] [--sources N] [--failing N]
+//                                [--latency-ms N] [--source-kbps N] [--apply-us N] [--range N]
+//                                [--buffer N] [--runs N]
+
+#include "BlockPipeline.hpp"
+
+#include <bts/blockchain/balance_operations.hpp>
+
+#include <fc/io/raw.hpp>
+#include <fc/network/http/server.hpp>
+#include <fc/thread/thread.hpp>
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QStringList>
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+int argumentValue(const QStringList& arguments, const QString& name, int defaultValue)
+{
+  int index = arguments.indexOf(name);
+  if (index != -1 && arguments.size() > index + 1)
+    return arguments[index + 1].toInt();
+  return defaultValue;
+}
+
+/// Blocks 1 to count, each with deposits to made up addresses; fixture[n - 1] is block n.
+std::vector<bts::blockchain::full_block> fixtureChain(uint32_t count, uint32_t transactionsPerBlock)
+{
+  std::vector<bts::blockchain::full_block> chain(count);
+  for (uint32_t n = 1; n <= count; ++n)
+  {
+    chain[n - 1].block_num = n;
+    chain[n - 1].user_transactions.resize(transactionsPerBlock);
+    for (uint32_t i = 0; i < transactionsPerBlock; ++i)
+    {
+      uint64_t seed = uint64_t(n) * transactionsPerBlock + i;
+      bts::blockchain::address owner;
+      owner.addr = fc::ripemd160::hash(reinterpret_cast<const char*>(&seed), sizeof(seed));
+      chain[n - 1].user_transactions[i].expiration = fc::time_point_sec(n);
+      chain[n - 1].user_transactions[i].operations.push_back(bts::blockchain::deposit_operation(owner, bts::blockchain::asset(1)));
+    }
+  }
+  return chain;
+}
+
+/// Serves the fixture chain like a wallet with sync/serve_blocks on, or fails every request.
+struct StandInPeer
+{
+  fc::http::server server;
+
+  StandInPeer(const std::vector<bts::blockchain::full_block>& chain, fc::microseconds latency, uint32_t kbps, bool failing)
+  {
+    server.listen(fc::ip::endpoint(fc::ip::address("127.0.0.1"), 0));
+    server.on_request([&chain, latency, kbps, failing](const fc::http::request& request, const fc::http::server::response& response) {
+      fc::usleep(latency);
+      std::vector<char> body;
+      if (failing)
+      {
+        response.set_status(fc::http::reply::InternalServerError);
+      }
+      else if (request.path == "/blocks/head")
+      {
+        std::string head = std::to_string(chain.size());
+        body.assign(head.begin(), head.end());
+        response.set_status(fc::http::reply::OK);
+      }
+      else
+      {
+        //"/blocks/<first>/<count>"
+        auto slash = request.path.rfind('/');
+        uint32_t first = uint32_t(std::stoul(request.path.substr(8, slash - 8)));
+        uint32_t count = uint32_t(std::stoul(request.path.substr(slash + 1)));
+        auto begin = chain.begin() + std::min<size_t>(first - 1, chain.size());
+        auto end = chain.begin() + std::min<size_t>(size_t(first) - 1 + count, chain.size());
+        body = fc::raw::pack(std::vector<bts::blockchain::full_block>(begin, end));
+        //The peer's upload rate
+        if (kbps)
+          fc::usleep(fc::microseconds(int64_t(body.size()) * 1000000 / (int64_t(kbps) * 1024)));
+        response.set_status(fc::http::reply::OK);
+      }
+      response.set_length(body.size());
+      if (!body.empty())
+        response.write(body.data(), body.size());
+    });
+  }
+
+  std::string url() { return "http://127.0.0.1:" + std::to_string(server.get_local_endpoint().port()); }
+};
+
+/// Validation is CPU work on the applying thread, so spin rather than sleep.
+void spin(fc::microseconds duration)
+{
+  QElapsedTimer timer;
+  timer.start();
+  while (timer.nsecsElapsed() / 1000 < duration.count())
+    ;
+}
+
+void report(const std::string& name, std::vector<double> samples, uint32_t blocks, const BlockPipeline::result& last)
+{
+  std::sort(samples.begin(), samples.end());
+  double total = 0;
+  for (double sample : samples)
+    total += sample;
+  double mean = total / samples.size();
+
+  std::cout << "  " << name << ": n=" << samples.size()
+            << " mean=" << mean << "ms"
+            << " p50=" << samples[samples.size() / 2] << "ms"
+            << " max=" << samples.back() << "ms"
+            << " (" << blocks / (mean / 1000) << " blocks/s; last run: applier waited "
+            << last.waiting.count() / 1000 << "ms, applied for " << last.applying.count() / 1000 << "ms, "
+            << last.retried_ranges << " ranges retried)\n";
+}
+
+} // anonymous
+
+int main(int argc, char** argv)
+{
+  QCoreApplication app(argc, argv);
+  const QStringList arguments = app.arguments();
+  const uint32_t blocks = uint32_t(std::max(1, argumentValue(arguments, "--blocks", 20000)));
+  const uint32_t transactions = uint32_t(std::max(0, argumentValue(arguments, "--transactions", 5)));
+  const int sources = std::max(1, argumentValue(arguments, "--sources", 4));
+  const int failing = std::max(0, argumentValue(arguments, "--failing", 0));
+  const fc::microseconds latency = fc::milliseconds(argumentValue(arguments, "--latency-ms", 50));
+  const uint32_t kbps = uint32_t(std::max(0, argumentValue(arguments, "--source-kbps", 2048)));
+  const fc::microseconds applyCost = fc::microseconds(argumentValue(arguments, "--apply-us", 200));
+  const int runs = std::max(1, argumentValue(arguments, "--runs", 3));
+
+  BlockPipeline::config pipelined;
+  pipelined.range_size = uint32_t(std::max(1, argumentValue(arguments, "--range", int(pipelined.range_size))));
+  pipelined.max_buffered_ranges = uint32_t(std::max(1, argumentValue(arguments, "--buffer", int(pipelined.max_buffered_ranges))));
+  BlockPipeline::config sequential = pipelined;
+  sequential.max_buffered_ranges = 1;
+
+  const std::vector<bts::blockchain::full_block> chain = fixtureChain(blocks, transactions);
+  fc::thread peerThread("stand-in peers");
+  std::vector<std::unique_ptr<StandInPeer>> standIns;
+  std::vector<std::string> urls;
+  peerThread.async([&] {
+    //Failing sources first in the list, where they do the most harm
+    for (int i = 0; i < failing + sources; ++i)
+    {
+      standIns.emplace_back(new StandInPeer(chain, latency, kbps, i < failing));
+      urls.push_back(standIns.back()->url());
+    }
+  }).wait();
+
+  std::cout << blocks << " blocks of " << transactions << " transactions, " << sources << " sources ("
+            << failing << " more failing), " << latency.count() / 1000 << "ms latency, " << kbps << "KB/s per source, "
+            << applyCost.count() << "us to apply a block, ranges of " << pipelined.range_size << ", " << runs << " runs\n";
+
+  fc::thread syncThread("sync");
+  int errors = 0;
+  syncThread.async([&] {
+    auto measure = [&](const std::string& name, BlockPipeline::config c, const std::vector<std::string>& from) {
+      std::vector<double> samples;
+      BlockPipeline::result last;
+      for (int run = 0; run < runs; ++run)
+      {
+        uint32_t expected = 1;
+        BlockPipeline pipeline(&BlockPipeline::fetch_over_http, c);
+        last = pipeline.run(1, blocks, from, [&](const bts::blockchain::full_block& block) {
+          if (block.block_num != expected++)
+            ++errors;
+          spin(applyCost);
+        });
+        if (last.blocks_applied != blocks)
+          ++errors;
+        samples.push_back(last.elapsed.count() / 1000.0);
+      }
+      report(name, samples, blocks, last);
+    };
+
+    std::vector<std::string> working(urls.begin() + failing, urls.end());
+    measure("one source, fetch then apply", sequential, std::vector<std::string>(1, working.front()));
+    measure("one source, pipelined", pipelined, std::vector<std::string>(1, working.front()));
+    measure(std::to_string(sources) + " sources, pipelined", pipelined, working);
+    if (failing)
+      measure(std::to_string(sources) + " sources and " + std::to_string(failing) + " failing, pipelined", pipelined, urls);
+  }).wait();
+
+  peerThread.async([&] { standIns.clear(); }).wait();
+  if (errors)
+    std::cerr << errors << " blocks applied out of order, or runs that missed blocks" << std::endl;
+  return errors ? 1 : 0;
+}
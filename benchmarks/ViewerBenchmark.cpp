@@ -0,0 +1,177 @@
+// Measures paint cost, input-to-paint latency and CPU time per frame of Html5Viewer while
+// scrolling a synthetic, transaction-history-like page. Built twice (see CMakeLists.txt) so
+// the QGraphicsView hosted viewer and the plain QWebView viewer can be compared on the same
+// machine. The QGraphicsView flavour runs once per rendering configuration.
+//
+// Usage: viewer_benchmark_<flavour> [--rows N] [--iterations N]
+// Run with QT_QPA_PLATFORM=offscreen to measure software rendering without a display.
+
+#include "html5viewer/html5viewer.h"
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QStringList>
+#include <QWheelEvent>
+
+#include <algorithm>
+#include <ctime>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+
+/// Counts paint events delivered to the widget WebKit renders into.
+class PaintProbe : public QObject
+{
+public:
+  int paints = 0;
+
+  virtual bool eventFilter(QObject* object, QEvent* event) override
+  {
+    if (event->type() == QEvent::Paint)
+      ++paints;
+    return QObject::eventFilter(object, event);
+  }
+};
+
+struct Scenario
+{
+  const char*                   name;
+  Html5Viewer::RenderingOptions options;
+};
+
+QString syntheticHistoryPage(int rows)
+{
+  QString page = "<html><head><style>"
+                 "body { font-family: sans-serif; margin: 0; }"
+                 "tr:nth-child(odd) { background: #f4f4f4; }"
+                 "td { padding: 6px 12px; border-bottom: 1px solid #ddd; }"
+                 "</style></head><body><table width='100%'>";
+  for (int i = 0; i < rows; ++i)
+    page += QStringLiteral("<tr><td>%1</td><td>2014-12-%2T10:00:00</td><td>account-%3</td>"
+                           "<td>account-%4</td><td align='right'>%5.00000 BTS</td><td>memo %1</td></tr>")
+        .arg(i).arg(i % 28 + 1, 2, 10, QChar('0')).arg(i % 97).arg(i % 89).arg(i * 17 % 10000);
+  page += "</table></body></html>";
+  return page;
+}
+
+int argumentValue(const QStringList& arguments, const QString& name, int defaultValue)
+{
+  int index = arguments.indexOf(name);
+  if (index != -1 && arguments.size() > index + 1)
+    return arguments[index + 1].toInt();
+  return defaultValue;
+}
+
+void report(const char* name, std::vector<double> samples)
+{
+  if (samples.empty())
+  {
+    std::cout << "  " << name << ": no samples\n";
+    return;
+  }
+
+  std::sort(samples.begin(), samples.end());
+  double total = 0;
+  for (double sample : samples)
+    total += sample;
+
+  std::cout << "  " << name << ": n=" << samples.size()
+            << " mean=" << total / samples.size() << "ms"
+            << " p50=" << samples[samples.size() / 2] << "ms"
+            << " p99=" << samples[samples.size() * 99 / 100] << "ms"
+            << " max=" << samples.back() << "ms\n";
+}
+
+void runScenario(QApplication& app, const Scenario& scenario, const QString& page, int iterations)
+{
+  Html5Viewer viewer;
+  viewer.setRenderingOptions(scenario.options);
+  viewer.resize(1024, 768);
+  viewer.show();
+
+  QEventLoop loadLoop;
+  QObject::connect(viewer.webView(), &Html5Viewer::WebView::loadFinished, &loadLoop, &QEventLoop::quit);
+  viewer.webView()->setHtml(page);
+  loadLoop.exec();
+
+#ifdef HTML5VIEWER_PLAIN_WEBVIEW
+  QWidget* target = viewer.webView();
+#else
+  QWidget* target = viewer.findChild<QGraphicsView*>()->viewport();
+#endif
+
+  PaintProbe probe;
+  target->installEventFilter(&probe);
+
+  std::vector<double> paintTimes;
+  std::vector<double> inputToPaintTimes;
+  QElapsedTimer timer;
+
+  //Scroll pass: only what the wheel events damage gets repainted
+  std::clock_t scrollCpuStart = std::clock();
+  int scrollPaintsStart = probe.paints;
+  for (int i = 0; i < iterations; ++i)
+  {
+    //Scroll down for the first half of the run and back up for the second, so we never hit the end of the page
+    int delta = i < iterations / 2 ? -120 : 120;
+    QPointF position(target->width() / 2, target->height() / 2);
+    QWheelEvent wheel(position, target->mapToGlobal(position.toPoint()), delta, Qt::NoButton, Qt::NoModifier);
+
+    int paintsBefore = probe.paints;
+    timer.start();
+    QApplication::sendEvent(target, &wheel);
+    while (probe.paints == paintsBefore && timer.elapsed() < 1000)
+      app.processEvents();
+    if (probe.paints != paintsBefore)
+      inputToPaintTimes.push_back(timer.nsecsElapsed() / 1000000.0);
+  }
+  double scrollCpuMs = double(std::clock() - scrollCpuStart) * 1000 / CLOCKS_PER_SEC;
+  int scrollFrames = std::max(1, probe.paints - scrollPaintsStart);
+
+  //Repaint pass: the whole viewport every time
+  for (int i = 0; i < iterations; ++i)
+  {
+    timer.start();
+    target->repaint();
+    paintTimes.push_back(timer.nsecsElapsed() / 1000000.0);
+  }
+
+  std::cout << scenario.name << "\n";
+  report("full repaint", paintTimes);
+  report("input to paint", inputToPaintTimes);
+  std::cout << "  scroll cpu per frame: " << scrollCpuMs / scrollFrames << "ms over " << scrollFrames << " frames\n";
+}
+
+} // anonymous
+
+int main(int argc, char** argv)
+{
+  QApplication app(argc, argv);
+  const int rows = argumentValue(app.arguments(), "--rows", 2000);
+  const int iterations = argumentValue(app.arguments(), "--iterations", 300);
+  const QString page = syntheticHistoryPage(rows);
+
+  std::vector<Scenario> scenarios;
+#ifdef HTML5VIEWER_PLAIN_WEBVIEW
+  scenarios.push_back({"plain QWebView", Html5Viewer::RenderingOptions()});
+#else
+  Html5Viewer::RenderingOptions options;
+  scenarios.push_back({"QGraphicsView: defaults (minimal update, no item cache, untiled)", options});
+  options.tiledBackingStore = true;
+  scenarios.push_back({"QGraphicsView: minimal update, no item cache, tiled", options});
+  options.tiledBackingStore = false;
+  options.viewportUpdateMode = Html5Viewer::FullViewportUpdate;
+  scenarios.push_back({"QGraphicsView: full update, no item cache, untiled", options});
+  options.viewportUpdateMode = Html5Viewer::MinimalViewportUpdate;
+  options.itemCacheMode = Html5Viewer::DeviceCoordinateCache;
+  scenarios.push_back({"QGraphicsView: minimal update, device cache, untiled", options});
+#endif
+
+  std::cout << rows << " rows, " << iterations << " iterations per pass\n";
+  for (const Scenario& scenario : scenarios)
+    runScenario(app, scenario, page, iterations);
+  return 0;
+}
@@ -0,0 +1,168 @@
+// Measures what it costs to check one block's transactions against the wallet's addresses as
+// the wallet grows, with the exact address set alone and behind the AddressFilter that
+// WalletRescanner uses. Blocks are synthetic: every output is a deposit, and one in a
+// thousand goes to the wallet; the transaction 500 later spends it again, so withdraws are
+// matched too. Also reports the filter's size and false positive rate.
+//
+// Usage: wallet_match_benchmark [--transactions N] [--blocks N] [--max-keys N]
+// Wallet sizes go from 10 keys up to --max-keys (100000 by default), by factors of ten.
+
+#include "AddressFilter.hpp"
+#include "WalletRescanner.hpp"
+
+#include <bts/blockchain/balance_operations.hpp>
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QStringList>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace
+{
+
+int argumentValue(const QStringList& arguments, const QString& name, int defaultValue)
+{
+  int index = arguments.indexOf(name);
+  if (index != -1 && arguments.size() > index + 1)
+    return arguments[index + 1].toInt();
+  return defaultValue;
+}
+
+bts::blockchain::address syntheticAddress(uint64_t n)
+{
+  bts::blockchain::address address;
+  address.addr = fc::ripemd160::hash(reinterpret_cast<const char*>(&n), sizeof(n));
+  return address;
+}
+
+/// Keys are numbered from 0; outputs to anyone else use numbers from the top of the range.
+std::vector<bts::blockchain::signed_transaction> syntheticBlock(uint32_t block, int transactionCount, int keyCount)
+{
+  std::vector<bts::blockchain::signed_transaction> transactions(transactionCount);
+  for (int i = 0; i < transactionCount; ++i)
+  {
+    uint64_t n = uint64_t(block) * transactionCount + i;
+    auto toWallet = [keyCount](uint64_t n) {
+      return bts::blockchain::deposit_operation(syntheticAddress(n / 1000 % keyCount), bts::blockchain::asset(1));
+    };
+    if (n % 1000 == 500)
+      transactions[i].operations.push_back(bts::blockchain::withdraw_operation(toWallet(n - 500).condition.get_address(), 1));
+    transactions[i].operations.push_back(n % 1000 == 0 ? toWallet(n)
+                                                       : bts::blockchain::deposit_operation(syntheticAddress(~n), bts::blockchain::asset(1)));
+  }
+  return transactions;
+}
+
+/// The same matching as WalletRescanner for deposits and withdraws, without the filter.
+/// Balances deposited to the wallet are added to walletBalances, for the withdraws after.
+bool exactMatch(const std::unordered_set<bts::blockchain::address>& addresses,
+                std::unordered_set<bts::blockchain::balance_id_type>& walletBalances,
+                const bts::blockchain::signed_transaction& transaction)
+{
+  bool match = false;
+  for (const auto& op : transaction.operations)
+  {
+    if (op.type.value == bts::blockchain::withdraw_op_type)
+    {
+      match |= walletBalances.count(op.as<bts::blockchain::withdraw_operation>().balance_id) != 0;
+      continue;
+    }
+    auto deposit = op.as<bts::blockchain::deposit_operation>();
+    auto owner = deposit.condition.owner();
+    if (owner && addresses.count(*owner))
+    {
+      walletBalances.insert(deposit.condition.get_address());
+      match = true;
+    }
+  }
+  return match;
+}
+
+/// WalletRescanner::check, settling withdraws against the balances seen received so far.
+bool filteredMatch(const WalletRescanner& scanner, std::unordered_set<bts::blockchain::balance_id_type>& walletBalances,
+                   const bts::blockchain::signed_transaction& transaction)
+{
+  auto match = scanner.check(transaction);
+  walletBalances.insert(match.received.begin(), match.received.end());
+  return match.ours || std::any_of(match.spent.begin(), match.spent.end(),
+                                   [&](const bts::blockchain::balance_id_type& id) { return walletBalances.count(id) != 0; });
+}
+
+void report(const std::string& name, std::vector<double> samples)
+{
+  std::sort(samples.begin(), samples.end());
+  double total = 0;
+  for (double sample : samples)
+    total += sample;
+
+  std::cout << "    " << name << ": n=" << samples.size()
+            << " mean=" << total / samples.size() << "us"
+            << " p50=" << samples[samples.size() / 2] << "us"
+            << " p99=" << samples[samples.size() * 99 / 100] << "us"
+            << " max=" << samples.back() << "us per block\n";
+}
+
+} // anonymous
+
+int main(int argc, char** argv)
+{
+  QCoreApplication app(argc, argv);
+  const QStringList arguments = app.arguments();
+  const int transactionCount = std::max(1, argumentValue(arguments, "--transactions", 200));
+  const int blockCount = std::max(1, argumentValue(arguments, "--blocks", 2000));
+  const int maxKeys = std::max(10, argumentValue(arguments, "--max-keys", 100000));
+
+  std::vector<std::vector<bts::blockchain::signed_transaction>> blocks;
+  std::cout << transactionCount << " transactions per block, " << blockCount << " blocks\n";
+
+  for (int keyCount = 10; keyCount <= maxKeys; keyCount *= 10)
+  {
+    std::unordered_set<bts::blockchain::address> addresses;
+    for (int i = 0; i < keyCount; ++i)
+      addresses.insert(syntheticAddress(i));
+    blocks.clear();
+    for (int block = 0; block < blockCount; ++block)
+      blocks.push_back(syntheticBlock(block, transactionCount, keyCount));
+
+    WalletRescanner scanner(nullptr, fc::thread::current(), addresses, {}, 1);
+    std::unordered_set<bts::blockchain::balance_id_type> exactBalances, filteredBalances;
+    AddressFilter filter(addresses);
+    std::vector<double> exact, filtered;
+    uint64_t exactMatches = 0, filteredMatches = 0, outputs = 0, falsePositives = 0;
+    QElapsedTimer timer;
+    for (const auto& block : blocks)
+    {
+      timer.start();
+      for (const auto& transaction : block)
+        exactMatches += exactMatch(addresses, exactBalances, transaction);
+      exact.push_back(timer.nsecsElapsed() / 1000.0);
+
+      timer.start();
+      for (const auto& transaction : block)
+        filteredMatches += filteredMatch(scanner, filteredBalances, transaction);
+      filtered.push_back(timer.nsecsElapsed() / 1000.0);
+
+      for (const auto& transaction : block)
+      {
+        auto owner = *transaction.operations.back().as<bts::blockchain::deposit_operation>().condition.owner();
+        ++outputs;
+        falsePositives += filter.may_contain(owner) && !addresses.count(owner);
+      }
+    }
+    if (exactMatches != filteredMatches) {
+      std::cerr << "Filtered matching found " << filteredMatches << " transactions instead of " << exactMatches << std::endl;
+      return 1;
+    }
+
+    std::cout << "  " << keyCount << " keys, filter " << filter.size_in_bytes() / 1024.0 << "KB, "
+              << 100.0 * falsePositives / outputs << "% false positives, " << exactMatches << " matches\n";
+    report("exact set", exact);
+    report("filter + exact set", filtered);
+  }
+  return 0;
+}
@@ -0,0 +1,272 @@
+// Drives synthetic, signed web update packages through the same steps the wallet takes for a
+// real one: download, signature check, install to the data dir, and on the next start reading
+// the package back, decompressing it, deserializing it and rebuilding the file map. Reports
+// wall time and peak RSS per stage so package format and streaming changes can be compared.
+//
+// Usage: webupdate_benchmark [--size MB] [--files N] [--iterations N] [--url package-url]
+// Without --url the package is downloaded from a local file through QNetworkAccessManager.
+// To time a real socket instead, pass the http:// URL of a file of similar size on a local
+// server; the download stage then fetches that and the later stages use the generated package.
+// Peak RSS is only reported on Linux, where it can be reset between stages.
+
+#include "WebAssetStore.hpp"
+#include "WebUpdates.hpp"
+
+#include <fc/compress/lzma.hpp>
+#include <fc/crypto/elliptic.hpp>
+#include <fc/crypto/sha256.hpp>
+#include <fc/io/raw.hpp>
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QStringList>
+#include <QTemporaryDir>
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+typedef std::vector<std::pair<std::string, std::vector<char>>> PackageContents;
+
+struct Stage
+{
+  std::vector<double> milliseconds;
+  long                peakRssKb = 0;
+};
+
+int argumentValue(const QStringList& arguments, const QString& name, int defaultValue)
+{
+  int index = arguments.indexOf(name);
+  if (index != -1 && arguments.size() > index + 1)
+    return arguments[index + 1].toInt();
+  return defaultValue;
+}
+
+/// Resets the kernel's peak RSS (VmHWM) to the current RSS.
+void resetPeakRss()
+{
+#ifdef Q_OS_LINUX
+  QFile clearRefs("/proc/self/clear_refs");
+  if (clearRefs.open(QIODevice::WriteOnly))
+    clearRefs.write("5");
+#endif
+}
+
+long peakRssKb()
+{
+#ifdef Q_OS_LINUX
+  QFile status("/proc/self/status");
+  if (status.open(QIODevice::ReadOnly | QIODevice::Text))
+    while (!status.atEnd())
+    {
+      QByteArray line = status.readLine();
+      if (line.startsWith("VmHWM:"))
+        return line.mid(6).trimmed().split(' ').first().toLong();
+    }
+#endif
+  return 0;
+}
+
+/// Files that look like a GUI build: mostly text that compresses like minified JS,
+/// with one in eight files being incompressible like images and fonts.
+PackageContents syntheticContents(int totalMegabytes, int fileCount)
+{
+  static const std::string text = "angular.module('app').controller('AccountController', function($scope, Wallet, Blockchain) {"
+                                  " $scope.account = Wallet.accounts[$scope.name]; $scope.balances = {}; });\n";
+  const size_t fileSize = std::max<size_t>(1, size_t(totalMegabytes) * 1024 * 1024 / std::max(1, fileCount));
+
+  PackageContents contents;
+  uint32_t random = 0x2545F491;
+  for (int i = 0; i < fileCount; ++i)
+  {
+    std::vector<char> data(fileSize);
+    bool binary = i % 8 == 7;
+    for (size_t j = 0; j < fileSize; ++j)
+    {
+      random = random * 1664525 + 1013904223;
+      data[j] = binary ? char(random >> 24) : text[(j + i) % text.size()];
+    }
+    contents.emplace_back(QStringLiteral("%1/file-%2.%3").arg(i % 4 ? "js" : "img").arg(i).arg(binary ? "png" : "js").toStdString(),
+                          std::move(data));
+  }
+  return contents;
+}
+
+/// Packs and signs the contents the way web update packages are published.
+QByteArray buildPackage(const PackageContents& contents, const std::vector<fc::ecc::private_key>& signers,
+                        WebUpdateManifest::UpdateDetails& description)
+{
+  std::vector<char> compressed = fc::lzma_compress(fc::raw::pack(contents));
+  QByteArray package(compressed.data(), int(compressed.size()));
+
+  description.timestamp = fc::time_point::now();
+  description.releaseNotes = "Synthetic benchmark package";
+  description.signatures.clear();
+
+  fc::sha256::encoder enc;
+  enc.write(package.data(), package.size());
+  std::string desc = description.signable_string();
+  enc.write(desc.c_str(), desc.size());
+  auto hash = enc.result();
+  for (const auto& signer : signers)
+    description.signatures.insert(signer.sign_compact(hash));
+  return package;
+}
+
+QByteArray download(QNetworkAccessManager& network, const QUrl& url)
+{
+  QEventLoop loop;
+  QNetworkReply* reply = network.get(QNetworkRequest(url));
+  QObject::connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
+  loop.exec();
+  QByteArray data = reply->error() == QNetworkReply::NoError ? reply->readAll() : QByteArray();
+  reply->deleteLater();
+  return data;
+}
+
+/// Times one stage and folds its peak RSS into the stage's maximum.
+template<typename Work>
+void measure(Stage& stage, Work&& work)
+{
+  resetPeakRss();
+  QElapsedTimer timer;
+  timer.start();
+  work();
+  stage.milliseconds.push_back(timer.nsecsElapsed() / 1000000.0);
+  stage.peakRssKb = std::max(stage.peakRssKb, peakRssKb());
+}
+
+void report(const std::string& name, std::vector<double> samples, long peakRssKb)
+{
+  if (samples.empty())
+    return;
+
+  std::sort(samples.begin(), samples.end());
+  double total = 0;
+  for (double sample : samples)
+    total += sample;
+
+  std::cout << "  " << name << ": n=" << samples.size()
+            << " mean=" << total / samples.size() << "ms"
+            << " p50=" << samples[samples.size() / 2] << "ms"
+            << " max=" << samples.back() << "ms"
+            << " peak_rss=" << peakRssKb / 1024.0 << "MB\n";
+}
+
+} // anonymous
+
+int main(int argc, char** argv)
+{
+  QCoreApplication app(argc, argv);
+  const QStringList arguments = app.arguments();
+  const int megabytes = argumentValue(arguments, "--size", 8);
+  const int fileCount = std::max(1, argumentValue(arguments, "--files", 200));
+  const int iterations = std::max(1, argumentValue(arguments, "--iterations", 5));
+
+  QTemporaryDir workDir;
+  if (!workDir.isValid()) {
+    std::cerr << "Unable to create a temporary directory" << std::endl;
+    return 1;
+  }
+  QDir dataDir(workDir.path());
+
+  std::vector<fc::ecc::private_key> signers;
+  std::unordered_set<bts::blockchain::address> signingKeys;
+  for (uint8_t i = 0; i < WEB_UPDATES_SIGNATURE_REQUIREMENT; ++i)
+  {
+    signers.push_back(fc::ecc::private_key::generate());
+    signingKeys.insert(bts::blockchain::address(signers.back().get_public_key()));
+  }
+
+  WebUpdateManifest::UpdateDetails description;
+  QByteArray package = buildPackage(syntheticContents(megabytes, fileCount), signers, description);
+
+  QString packagePath = dataDir.absoluteFilePath("package.pak");
+  QFile packageFile(packagePath);
+  if (!packageFile.open(QIODevice::WriteOnly) || packageFile.write(package) != package.size()) {
+    std::cerr << "Unable to write " << packagePath.toStdString() << std::endl;
+    return 1;
+  }
+  packageFile.close();
+
+  int urlIndex = arguments.indexOf("--url");
+  QUrl url = urlIndex != -1 && arguments.size() > urlIndex + 1 ? QUrl(arguments[urlIndex + 1]) : QUrl::fromLocalFile(packagePath);
+
+  std::cout << fileCount << " files, " << megabytes << "MB unpacked, " << package.size() / 1024 << "KB packed, "
+            << iterations << " iterations\n"
+            << "package: " << packagePath.toStdString() << "\n"
+            << "source: " << url.toString().toStdString() << "\n";
+
+  QNetworkAccessManager network;
+  std::map<std::string, Stage> stages;
+  WebAssetStore assets;
+  for (int i = 0; i < iterations; ++i)
+  {
+    QByteArray downloaded;
+    measure(stages["1 download"], [&] { downloaded = download(network, url); });
+    if (downloaded.isEmpty()) {
+      std::cerr << "Unable to download " << url.toString().toStdString() << std::endl;
+      return 1;
+    }
+    downloaded = package;
+
+    bool verified = false;
+    measure(stages["2 verify"], [&] { verified = verifyWebUpdateSignature(description, downloaded, signingKeys); });
+    if (!verified) {
+      std::cerr << "Synthetic package failed signature verification" << std::endl;
+      return 1;
+    }
+
+    measure(stages["3 install"], [&] { installWebUpdate(dataDir, description, downloaded); });
+    downloaded.clear();
+
+    //What loadInstalledWebUpdate and unpackWebUpdate do at the next start, one step at a time
+    QByteArray installed;
+    measure(stages["4 read"], [&] {
+      QFile file(dataDir.absoluteFilePath("web.dat"));
+      file.open(QIODevice::ReadOnly);
+      installed = file.readAll();
+    });
+
+    std::vector<char> decompressed;
+    measure(stages["5 decompress"], [&] {
+      decompressed = fc::lzma_decompress(std::vector<char>(installed.begin(), installed.end()));
+    });
+
+    PackageContents contents;
+    measure(stages["6 unpack"], [&] {
+      fc::datastream<const char*> ds(decompressed.data(), decompressed.size());
+      fc::raw::unpack(ds, contents);
+      decompressed = std::vector<char>();
+    });
+
+    WebPackageFiles files;
+    measure(stages["7 map rebuild"], [&] {
+      for (auto& file : contents)
+        files[std::move(file.first)] = std::move(file.second);
+      contents.clear();
+    });
+
+    measure(stages["8 set package"], [&] { assets.set_package(std::move(files)); });
+
+    //The same load path as a single call, for comparison with the sum of the steps
+    WebPackageFiles unpacked;
+    measure(stages["9 unpackWebUpdate"], [&] { unpackWebUpdate(installed, unpacked); });
+  }
+
+  for (const auto& stage : stages)
+    report(stage.first, stage.second.milliseconds, stage.second.peakRssKb);
+  return 0;
+}
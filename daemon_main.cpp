@@ -0,0 +1,18 @@
+#include "BitSharesDaemon.hpp"
+#include "CommandClient.hpp"
+#include <boost/filesystem.hpp>
+
+#include <string>
+
+//The headless daemon: built apart from the GUI so it links neither WebKit nor the widgets
+int main( int argc, char** argv )
+{
+  #ifdef WIN32
+    // See main.cpp
+    boost::filesystem::path::imbue(std::locale());
+  #endif
+  for (int i = 1; i < argc; ++i)
+    if (std::string(argv[i]) == "--command")
+      return CommandClient::run(argc, argv);
+  return BitSharesDaemon::run(argc, argv);
+}
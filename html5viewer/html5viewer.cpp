@@ -13,16 +13,29 @@
 #include <QDir>
 #include <QFileInfo>
 #include <QVBoxLayout>
+#ifndef HTML5VIEWER_PLAIN_WEBVIEW
 #include <QGraphicsView>
 #include <QGraphicsScene>
 #include <QGraphicsSceneContextMenuEvent>
 #include <QGraphicsLinearLayout>
-#include <QGraphicsWebView>
+#endif
 #include <QWebSettings>
 #include <QWebFrame>
+#include <QElapsedTimer>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QKeyEvent>
+#include <QSettings>
+#include <QTimer>
 
 #include <bts/blockchain/config.hpp>
 
+#include "Metrics.hpp"
+
+#if defined(TOUCH_OPTIMIZED_NAVIGATION) && defined(HTML5VIEWER_PLAIN_WEBVIEW)
+#error "TOUCH_OPTIMIZED_NAVIGATION requires the QGraphicsWebView based viewer"
+#endif
+
 #ifdef TOUCH_OPTIMIZED_NAVIGATION
 #include <QTimer>
 #include <QGraphicsSceneMouseEvent>
@@ -1050,15 +1063,143 @@ QGraphicsWebView* NavigationController::graphicsWebView() const
 }
 #endif // TOUCH_OPTIMIZED_NAVIGATION
 
+// Records paint duration, repainted area and input-to-paint latency of the widget
+// WebKit renders into, and draws them as an optional overlay.
+class FrameStatsRecorder
+{
+public:
+    FrameStatsRecorder();
+
+    static bool isInputEvent(QEvent::Type type);
+    static QRect overlayRect(const QWidget *widget);
+    static void drawOverlay(QPainter *painter, const QRect &rect);
+
+    void inputReceived();
+    void paintStarted(const QRegion &region);
+    void paintFinished();
+
+    QTimer m_overlayTimer;
+    bool m_overlayVisible;
+    QRect m_overlayRect;
+
+private:
+    QElapsedTimer m_clock;
+    qint64 m_pendingInputNs;
+    qint64 m_paintStartNs;
+    qint64 m_paintArea;
+    bool m_overlayOnlyPaint;
+};
+
+FrameStatsRecorder::FrameStatsRecorder()
+    : m_overlayVisible(false)
+    , m_pendingInputNs(-1)
+    , m_paintStartNs(0)
+    , m_paintArea(0)
+    , m_overlayOnlyPaint(false)
+{
+    m_clock.start();
+    m_overlayTimer.setInterval(500);
+}
+
+bool FrameStatsRecorder::isInputEvent(QEvent::Type type)
+{
+    switch (type) {
+    case QEvent::MouseButtonPress:
+    case QEvent::MouseButtonRelease:
+    case QEvent::MouseButtonDblClick:
+    case QEvent::Wheel:
+    case QEvent::KeyPress:
+    case QEvent::TouchBegin:
+        return true;
+    default:
+        return false;
+    }
+}
+
+QRect FrameStatsRecorder::overlayRect(const QWidget *widget)
+{
+    return QRect(widget->width() - 290, 10, 280, 70);
+}
+
+void FrameStatsRecorder::drawOverlay(QPainter *painter, const QRect &rect)
+{
+    Metrics::Histogram paint = Metrics::histogram("viewer.paint_ms");
+    Metrics::Histogram region = Metrics::histogram("viewer.paint_region_px");
+    Metrics::Histogram latency = Metrics::histogram("viewer.input_to_paint_ms");
+
+    painter->save();
+    painter->fillRect(rect, QColor(0, 0, 0, 180));
+    painter->setPen(Qt::white);
+    painter->drawText(rect.adjusted(8, 4, -8, -4), Qt::AlignLeft | Qt::AlignVCenter,
+                      QStringLiteral("frames %1\npaint p50 %2 ms, p99 %3 ms\nregion p50 %4 px\ninput to paint p50 %5 ms, p99 %6 ms")
+                      .arg(paint.count())
+                      .arg(paint.percentile(50), 0, 'f', 1).arg(paint.percentile(99), 0, 'f', 1)
+                      .arg(region.percentile(50), 0, 'f', 0)
+                      .arg(latency.percentile(50), 0, 'f', 1).arg(latency.percentile(99), 0, 'f', 1));
+    painter->restore();
+}
+
+void FrameStatsRecorder::inputReceived()
+{
+    // Latency is measured from the first input event not yet followed by a paint.
+    if (m_pendingInputNs < 0)
+        m_pendingInputNs = m_clock.nsecsElapsed();
+}
+
+void FrameStatsRecorder::paintStarted(const QRegion &region)
+{
+    // Overlay refreshes would otherwise show up as a stream of tiny frames.
+    m_overlayOnlyPaint = m_overlayVisible && m_overlayRect.contains(region.boundingRect());
+    m_paintArea = 0;
+    for (const QRect &rect : region.rects())
+        m_paintArea += qint64(rect.width()) * rect.height();
+    m_paintStartNs = m_clock.nsecsElapsed();
+}
+
+void FrameStatsRecorder::paintFinished()
+{
+    if (m_overlayOnlyPaint)
+        return;
+
+    qint64 now = m_clock.nsecsElapsed();
+    Metrics::increment("viewer.frames");
+    Metrics::record("viewer.paint_ms", (now - m_paintStartNs) / 1000000.0);
+    Metrics::record("viewer.paint_region_px", m_paintArea);
+    if (m_pendingInputNs >= 0) {
+        Metrics::record("viewer.input_to_paint_ms", (now - m_pendingInputNs) / 1000000.0);
+        m_pendingInputNs = -1;
+    }
+}
+
+#ifdef HTML5VIEWER_PLAIN_WEBVIEW
+// The page is hosted directly by the widget, so paint and input events reach
+// WebKit without going through a graphics scene.
+class Html5ViewerPrivate : public QWebView
+#else
 class Html5ViewerPrivate : public QGraphicsView
+#endif
 {
     Q_OBJECT
 public:
     Html5ViewerPrivate(QWidget *parent = 0);
 
+#ifndef HTML5VIEWER_PLAIN_WEBVIEW
     void resizeEvent(QResizeEvent *event);
+#endif
     static QString adjustPath(const QString &path);
 
+    void setOverlayVisible(bool visible);
+
+protected:
+#ifdef HTML5VIEWER_PLAIN_WEBVIEW
+    bool event(QEvent *event);
+    void paintEvent(QPaintEvent *event);
+#else
+    bool viewportEvent(QEvent *event);
+    void keyPressEvent(QKeyEvent *event);
+    void drawForeground(QPainter *painter, const QRectF &rect);
+#endif
+
 public Q_SLOTS:
     void quit();
 
@@ -1069,12 +1210,56 @@ Q_SIGNALS:
     void quitRequested();
 
 public:
-    QGraphicsWebView *m_webView;
+    Html5Viewer::WebView *m_webView;
+    FrameStatsRecorder m_frameStats;
 #ifdef TOUCH_OPTIMIZED_NAVIGATION
     NavigationController *m_controller;
 #endif // TOUCH_OPTIMIZED_NAVIGATION
 };
 
+#ifdef HTML5VIEWER_PLAIN_WEBVIEW
+Html5ViewerPrivate::Html5ViewerPrivate(QWidget *parent)
+    : QWebView(parent)
+{
+    m_webView = this;
+    connect(m_webView->page()->mainFrame(),
+            SIGNAL(javaScriptWindowObjectCleared()), SLOT(addToJavaScript()));
+    connect(&m_frameStats.m_overlayTimer, &QTimer::timeout, [this] {
+        update(m_frameStats.m_overlayRect);
+    });
+}
+
+bool Html5ViewerPrivate::event(QEvent *event)
+{
+    if (FrameStatsRecorder::isInputEvent(event->type()))
+        m_frameStats.inputReceived();
+    return QWebView::event(event);
+}
+
+void Html5ViewerPrivate::paintEvent(QPaintEvent *event)
+{
+    m_frameStats.m_overlayRect = FrameStatsRecorder::overlayRect(this);
+    m_frameStats.paintStarted(event->region());
+    QWebView::paintEvent(event);
+    m_frameStats.paintFinished();
+
+    if (m_frameStats.m_overlayVisible) {
+        QPainter painter(this);
+        FrameStatsRecorder::drawOverlay(&painter, m_frameStats.m_overlayRect);
+    }
+}
+
+void Html5ViewerPrivate::setOverlayVisible(bool visible)
+{
+    m_frameStats.m_overlayVisible = visible;
+    m_frameStats.m_overlayRect = FrameStatsRecorder::overlayRect(this);
+    if (visible)
+        m_frameStats.m_overlayTimer.start();
+    else
+        m_frameStats.m_overlayTimer.stop();
+    update();
+}
+#else
 Html5ViewerPrivate::Html5ViewerPrivate(QWidget *parent)
     : QGraphicsView(parent)
 {
@@ -1083,6 +1268,10 @@ Html5ViewerPrivate::Html5ViewerPrivate(QWidget *parent)
     setFrameShape(QFrame::NoFrame);
     setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
     setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    // The scene holds a single opaque item and no background, so there is nothing to
+    // cache behind it and no painter state worth saving between items.
+    setCacheMode(QGraphicsView::CacheNone);
+    setOptimizationFlags(QGraphicsView::DontSavePainterState | QGraphicsView::DontAdjustForAntialiasing);
 
     m_webView = new QGraphicsWebView;
     m_webView->setAcceptTouchEvents(true);
@@ -1095,13 +1284,61 @@ Html5ViewerPrivate::Html5ViewerPrivate(QWidget *parent)
 #endif // TOUCH_OPTIMIZED_NAVIGATION
     connect(m_webView->page()->mainFrame(),
             SIGNAL(javaScriptWindowObjectCleared()), SLOT(addToJavaScript()));
+    connect(&m_frameStats.m_overlayTimer, &QTimer::timeout, [this] {
+        viewport()->update(m_frameStats.m_overlayRect);
+    });
 }
 
 void Html5ViewerPrivate::resizeEvent(QResizeEvent *event)
 {
     m_webView->resize(event->size());
+    m_frameStats.m_overlayRect = FrameStatsRecorder::overlayRect(viewport());
+}
+
+bool Html5ViewerPrivate::viewportEvent(QEvent *event)
+{
+    if (FrameStatsRecorder::isInputEvent(event->type()))
+        m_frameStats.inputReceived();
+    if (event->type() != QEvent::Paint)
+        return QGraphicsView::viewportEvent(event);
+
+    m_frameStats.paintStarted(static_cast<QPaintEvent *>(event)->region());
+    bool result = QGraphicsView::viewportEvent(event);
+    m_frameStats.paintFinished();
+    return result;
+}
+
+void Html5ViewerPrivate::keyPressEvent(QKeyEvent *event)
+{
+    m_frameStats.inputReceived();
+    QGraphicsView::keyPressEvent(event);
+}
+
+void Html5ViewerPrivate::drawForeground(QPainter *painter, const QRectF &rect)
+{
+    QGraphicsView::drawForeground(painter, rect);
+    if (!m_frameStats.m_overlayVisible)
+        return;
+
+    // The overlay is laid out in viewport coordinates, not scene coordinates.
+    painter->save();
+    painter->resetTransform();
+    FrameStatsRecorder::drawOverlay(painter, m_frameStats.m_overlayRect);
+    painter->restore();
 }
 
+void Html5ViewerPrivate::setOverlayVisible(bool visible)
+{
+    m_frameStats.m_overlayVisible = visible;
+    m_frameStats.m_overlayRect = FrameStatsRecorder::overlayRect(viewport());
+    if (visible)
+        m_frameStats.m_overlayTimer.start();
+    else
+        m_frameStats.m_overlayTimer.stop();
+    viewport()->update();
+}
+#endif // HTML5VIEWER_PLAIN_WEBVIEW
+
 QString Html5ViewerPrivate::adjustPath(const QString &path)
 {
 #ifdef Q_OS_UNIX
@@ -1132,14 +1369,46 @@ void Html5ViewerPrivate::addToJavaScript()
     m_webView->page()->mainFrame()->addToJavaScriptWindowObject("Qt", this);
 }
 
+Html5Viewer::RenderingOptions::RenderingOptions()
+    : viewportUpdateMode(MinimalViewportUpdate)
+    , itemCacheMode(NoItemCache)
+    , tiledBackingStore(false)
+{
+}
+
+Html5Viewer::RenderingOptions Html5Viewer::RenderingOptions::fromSettings(QSettings &settings)
+{
+    RenderingOptions options;
+
+    const QString updateMode = settings.value("viewer/viewport_update_mode", "minimal").toString();
+    if (updateMode == "smart")
+        options.viewportUpdateMode = SmartViewportUpdate;
+    else if (updateMode == "bounding_rect")
+        options.viewportUpdateMode = BoundingRectViewportUpdate;
+    else if (updateMode == "full")
+        options.viewportUpdateMode = FullViewportUpdate;
+
+    const QString cacheMode = settings.value("viewer/item_cache_mode", "none").toString();
+    if (cacheMode == "item")
+        options.itemCacheMode = ItemCoordinateCache;
+    else if (cacheMode == "device")
+        options.itemCacheMode = DeviceCoordinateCache;
+
+    options.tiledBackingStore = settings.value("viewer/tiled_backing_store", options.tiledBackingStore).toBool();
+    return options;
+}
+
 Html5Viewer::Html5Viewer(QWidget *parent)
     : QWidget(parent)
     , m_d(new Html5ViewerPrivate(this))
 {
     webView()->page()->settings()->setAttribute( QWebSettings::PluginsEnabled, false );
     setOrientation(Html5Viewer::ScreenOrientationAuto);
+#ifndef HTML5VIEWER_PLAIN_WEBVIEW
     webView()->setAcceptHoverEvents(true);
+#endif
     webView()->setFocus(Qt::ActiveWindowFocusReason);
+    setRenderingOptions(RenderingOptions());
 
     connect(m_d, SIGNAL(quitRequested()), SLOT(close()));
     QVBoxLayout *layout = new QVBoxLayout;
@@ -1207,7 +1476,35 @@ void Html5Viewer::showExpanded()
 #endif
 }
 
-QGraphicsWebView *Html5Viewer::webView() const
+void Html5Viewer::setFrameStatsOverlayVisible(bool visible)
+{
+    m_d->setOverlayVisible(visible);
+}
+
+void Html5Viewer::setRenderingOptions(const RenderingOptions &options)
+{
+#ifdef HTML5VIEWER_PLAIN_WEBVIEW
+    Q_UNUSED(options);
+#else
+    static const QGraphicsView::ViewportUpdateMode updateModes[] = {
+        QGraphicsView::MinimalViewportUpdate, QGraphicsView::SmartViewportUpdate,
+        QGraphicsView::BoundingRectViewportUpdate, QGraphicsView::FullViewportUpdate
+    };
+    static const QGraphicsItem::CacheMode cacheModes[] = {
+        QGraphicsItem::NoCache, QGraphicsItem::ItemCoordinateCache, QGraphicsItem::DeviceCoordinateCache
+    };
+    m_d->setViewportUpdateMode(updateModes[options.viewportUpdateMode]);
+    m_d->m_webView->setCacheMode(cacheModes[options.itemCacheMode]);
+    m_d->m_webView->settings()->setAttribute(QWebSettings::TiledBackingStoreEnabled, options.tiledBackingStore);
+#endif
+}
+
+bool Html5Viewer::isFrameStatsOverlayVisible() const
+{
+    return m_d->m_frameStats.m_overlayVisible;
+}
+
+Html5Viewer::WebView *Html5Viewer::webView() const
 {
     return m_d->m_webView;
 }
@@ -4,7 +4,16 @@
 #include <QWidget>
 #include <QUrl>
 
-class QGraphicsWebView;
+class QSettings;
+
+// Define HTML5VIEWER_PLAIN_WEBVIEW to host the page in a plain QWebView
+// instead of a QGraphicsWebView inside a QGraphicsView scene.
+#ifdef HTML5VIEWER_PLAIN_WEBVIEW
+#include <QWebView>
+#else
+#include <QGraphicsView>
+#include <QGraphicsWebView>
+#endif
 
 class Html5Viewer : public QWidget
 {
@@ -17,6 +26,42 @@ public:
         ScreenOrientationAuto
     };
 
+#ifdef HTML5VIEWER_PLAIN_WEBVIEW
+    typedef QWebView WebView;
+#else
+    typedef QGraphicsWebView WebView;
+#endif
+
+    // Mirror QGraphicsView::ViewportUpdateMode and QGraphicsItem::CacheMode, which as nested
+    // enums can't be forward-declared, so the plain viewer needs no graphics view headers.
+    enum ViewportUpdateMode {
+        MinimalViewportUpdate,
+        SmartViewportUpdate,
+        BoundingRectViewportUpdate,
+        FullViewportUpdate
+    };
+    enum ItemCacheMode {
+        NoItemCache,
+        ItemCoordinateCache,
+        DeviceCoordinateCache
+    };
+
+    // Rendering choices of the QGraphicsView hosted viewer. The defaults repaint only the
+    // damaged rects and leave caching to WebKit. WebKit's tiled backing store, which keeps
+    // pre-rendered tiles around the visible area, stays off as before unless
+    // viewer/tiled_backing_store turns it on. The plain QWebView viewer ignores them.
+    struct RenderingOptions
+    {
+        RenderingOptions();
+        // Reads viewer/viewport_update_mode (minimal, smart, bounding_rect, full),
+        // viewer/item_cache_mode (none, item, device) and viewer/tiled_backing_store.
+        static RenderingOptions fromSettings(QSettings &settings);
+
+        ViewportUpdateMode viewportUpdateMode;
+        ItemCacheMode itemCacheMode;
+        bool tiledBackingStore;
+    };
+
     explicit Html5Viewer(QWidget *parent = 0);
     virtual ~Html5Viewer();
 
@@ -28,10 +73,16 @@ public:
 
     void showExpanded();
 
-    QGraphicsWebView *webView() const;
+    // Paint duration, repainted area and input-to-paint latency are always recorded
+    // into Metrics; this only toggles drawing them on top of the page.
+    void setFrameStatsOverlayVisible(bool visible);
+    void setRenderingOptions(const RenderingOptions &options);
+    bool isFrameStatsOverlayVisible() const;
+
+    WebView *webView() const;
 
 private:
     class Html5ViewerPrivate *m_d;
 };
 
-#endif 
+#endif
@@ -1,6 +1,10 @@
 #include "BitSharesApp.hpp"
+#include "CommandClient.hpp"
 #include <boost/filesystem.hpp>
 
+#include <iostream>
+#include <string>
+
 int main( int argc, char** argv )
 {
   #ifdef WIN32
@@ -8,5 +12,17 @@ int main( int argc, char** argv )
     // when used from a thread if we don't do this first.
     boost::filesystem::path::imbue(std::locale());
   #endif
+  //Decided before any application object exists: the command line client may not create a QApplication
+  for (int i = 1; i < argc; ++i)
+  {
+    if (std::string(argv[i]) == "--headless")
+    {
+      //This executable loads WebKit whatever it runs; the daemon is built without it
+      std::cerr << "--headless is no longer supported here; run " << argv[0] << "_daemon instead" << std::endl;
+      return 1;
+    }
+    if (std::string(argv[i]) == "--command")
+      return CommandClient::run(argc, argv);
+  }
   return BitSharesApp::run(argc, argv);
 }